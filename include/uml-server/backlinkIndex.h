@@ -0,0 +1,42 @@
+#pragma once
+
+#include "egm/id.h"
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace UML {
+
+    // BacklinkIndex
+    // index from an element to the elements referencing it along with the name of the set holding
+    // the reference. References are replaced per referencing element so the index can be updated
+    // straight from the sets of an element whenever it changes
+    class BacklinkIndex {
+        public:
+            using Reference = std::pair<EGM::ID, std::string>; // (element id, set name)
+        private:
+            // set names are few and repeated for every reference, keep each once
+            std::vector<std::string> m_set_names;
+            std::unordered_map<std::string, std::size_t> m_set_name_indices;
+            using IndexedReference = std::pair<EGM::ID, std::size_t>;
+
+            std::unordered_map<EGM::ID, std::vector<IndexedReference>> m_references; // source -> targets
+            std::unordered_map<EGM::ID, std::vector<IndexedReference>> m_backlinks; // target -> sources
+
+            std::size_t set_name_index(const std::string& set_name);
+            void remove_references(EGM::ID source);
+        public:
+            // set_references
+            // source - id of the referencing element
+            // references - (target id, set name) of every reference held by source, replaces what was indexed before
+            void set_references(EGM::ID source, const std::vector<Reference>& references);
+
+            // drop an element from the index, both what it references and what references it
+            void unindex(EGM::ID id);
+            void clear();
+
+            // return - (element id, set name) of every element referencing target
+            std::vector<Reference> referenced_by(EGM::ID target) const;
+    };
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "egm/id.h"
+#include <functional>
+#include <set>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace UML {
+
+    // ElementTypeIndex
+    // ids of elements grouped by element type, an element is under its own type and every type it inherits from.
+    // Ids of a type are kept ordered so a query can be resumed from the last id it returned no matter what
+    // was added or removed in between
+    class ElementTypeIndex {
+        private:
+            std::unordered_map<std::size_t, std::set<std::string, std::less<>>> m_ids_by_type;
+            std::unordered_map<EGM::ID, std::vector<std::size_t>> m_types;
+        public:
+            // index an element, an element indexed before under other types is moved
+            // element_types - the type of the element and every type it inherits from
+            void index(EGM::ID id, std::vector<std::size_t> element_types);
+            void unindex(EGM::ID id);
+            void clear();
+            std::size_t count(std::size_t element_type) const;
+            // return - true if id is indexed under element_type
+            bool is(EGM::ID id, std::size_t element_type) const;
+
+            // for_each
+            // element_type - type of elements to visit
+            // after - id to resume after, empty to start from the first id
+            // f - called in order with the id of each element, return false to stop
+            void for_each(std::size_t element_type, std::string_view after, std::function<bool(const std::string&)> f) const;
+    };
+}
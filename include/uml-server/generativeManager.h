@@ -29,7 +29,22 @@ namespace UML {
         protected:
             std::unordered_map<std::string, std::size_t> names_to_element_type;
             std::unordered_map<std::size_t, std::string> element_types_to_name;
+            // abstract types can't be created, they can still be asked for, e.g. every Classifier
+            std::unordered_map<std::string, std::size_t> names_to_abstract_element_type;
+            std::size_t m_meta_dump_chunk_size = META_MANAGER_DUMP_CHUNK_SIZE;
+            std::size_t m_meta_record_limit = META_MANAGER_RECORD_LIMIT;
         public:
+            // chunk_size - max meta elements of a meta manager loaded at once when saving
+            void set_meta_dump_chunk_size(std::size_t chunk_size) {
+                m_meta_dump_chunk_size = chunk_size;
+            }
+            // limit - max released meta elements of each meta manager kept serialized in memory, see MetaManager::set_record_limit
+            void set_meta_record_limit(std::size_t limit) {
+                m_meta_record_limit = limit;
+                for (auto& meta_manager_pair : m_meta_managers) {
+                    meta_manager_pair.second.set_record_limit(limit);
+                }
+            }
             virtual MetaManager& get_meta_manager(EGM::ID id) {
                 return m_meta_managers.at(id);
             }
@@ -61,6 +76,11 @@ namespace UML {
                                 BaseManager::template ElementType<First>::result,
                                 EGM::ElementInfo<First>::name()
                             );
+                    } else {
+                        server.names_to_abstract_element_type.emplace(
+                                EGM::ElementInfo<First>::name(), 
+                                BaseManager::template ElementType<First>::result
+                            );
                     }
                     
                     fill_names_to_element_type<EGM::TemplateTypeList<Rest...>>::fill(server);
@@ -71,7 +91,44 @@ namespace UML {
             struct fill_names_to_element_type<EGM::TemplateTypeList<>, Dummy> {
                 static void fill(GenerativeManager&) {}
             };
+
+            template <class List, class Dummy = void>
+            struct fill_element_types_of;
+
+            template <template <class> class First, template <class> class ... Rest, class Dummy>
+            struct fill_element_types_of<EGM::TemplateTypeList<First, Rest...>, Dummy> {
+                template <class El>
+                static void fill(El& el, std::vector<std::size_t>& element_types) {
+                    if (el.template is<First>()) {
+                        element_types.push_back(BaseManager::template ElementType<First>::result);
+                    }
+                    fill_element_types_of<EGM::TemplateTypeList<Rest...>>::fill(el, element_types);
+                }
+            };
+
+            template <class Dummy>
+            struct fill_element_types_of<EGM::TemplateTypeList<>, Dummy> {
+                template <class El>
+                static void fill(El&, std::vector<std::size_t>&) {}
+            };
+
+            // element type -> every type an element of it is, filled the first time an element of the type is seen
+            std::unordered_map<std::size_t, std::vector<std::size_t>> m_element_types_of;
         public:
+            // element_types_of
+            // el - element to get the types of
+            // return - the element type of el and of every type it inherits from
+            template <class El>
+            const std::vector<std::size_t>& element_types_of(El& el) {
+                auto types_match = m_element_types_of.find(el.getElementType());
+                if (types_match != m_element_types_of.end()) {
+                    return types_match->second;
+                }
+                std::vector<std::size_t> element_types;
+                fill_element_types_of<typename BaseManager::Types>::fill(el, element_types);
+                return m_element_types_of.emplace(el.getElementType(), std::move(element_types)).first->second;
+            }
+
             GenerativeManager() {
                 // link to serialization policy, also causes compiler
                 // error with improper config (no GenerativeSerializationPolicy in base hierarchy)
@@ -83,24 +140,48 @@ namespace UML {
             // generation_root : root of uml elements to generate a manager from
             // return : the ID of the created meta_manager for use of the manager and its elements
             EGM::ID generate(UmlManager::Implementation<Element>& generation_root) {
+                EGM::ID manager_id = generate_deferred(generation_root);
+                m_meta_managers.at(manager_id).discover_types();
+                return manager_id;
+            }
+
+            // generate a new MetaManager without discovering its types, the types are filled in by 
+            // stepping MetaManager::discover_types so the caller can interleave other work with it
+            // generation_root : root of uml elements to generate a manager from
+            // return : the ID of the created meta_manager
+            EGM::ID generate_deferred(UmlManager::Implementation<Element>& generation_root) {
                 EGM::ID manager_id = EGM::ID::randomID();
-                MetaManager& created_manager = m_meta_managers.emplace(manager_id, generation_root).first->second;
+                MetaManager& created_manager = m_meta_managers.emplace(
+                        std::piecewise_construct, 
+                        std::forward_as_tuple(manager_id), 
+                        std::forward_as_tuple(generation_root, true)
+                    ).first->second;
                 // set storage root to correspond to manager id
                 // this helps the generative manager quickly identify what meta manager an instance is part of
                 created_manager.m_storage_root->setID(manager_id);            
+                created_manager.set_record_limit(m_meta_record_limit);
                 return manager_id;
             }
 
+            // applied_meta_elements
+            // applying_element_id - id of a uml element
+            // return - (meta manager id, meta element id) of every stereotype applied to the element, 
+            //          answered from the meta managers' application indices so nothing is loaded
+            std::vector<std::pair<EGM::ID, EGM::ID>> applied_meta_elements(EGM::ID applying_element_id) {
+                std::vector<std::pair<EGM::ID, EGM::ID>> ret;
+                for (auto& meta_manager_pair : m_meta_managers) {
+                    for (auto& meta_element_id : meta_manager_pair.second.get_applied_meta_elements(applying_element_id)) {
+                        ret.emplace_back(meta_manager_pair.first, meta_element_id);
+                    }
+                }
+                return ret;
+            }
+
             void erase(EGM::AbstractElement& el) override {
-                // make sure any stereotype data is freed first
-                auto& uml_element = dynamic_cast<UmlManager::Implementation<Element>&>(el);
-                for (auto& applied_stereotype : uml_element.getAppliedStereotypes()) {
-                    // get meta_manager from applied_stereotype owning package (will be same id as manager)
-                    auto& meta_manager = get_meta_manager(applied_stereotype.getOwningPackage().id());
-
-                    // erase stereotype data so no hanging references to our base element
-                    auto& meta_element = *meta_manager.get(applied_stereotype.getID());
-                    meta_manager.erase(meta_element);        
+                // make sure any stereotype data is freed first so no hanging references to our base element
+                for (auto& applied_pair : applied_meta_elements(el.getID())) {
+                    auto& meta_manager = m_meta_managers.at(applied_pair.first);
+                    meta_manager.erase(*meta_manager.get(applied_pair.second));
                 }
 
                 // call super
@@ -108,20 +189,26 @@ namespace UML {
             }
 
             void release(EGM::AbstractElement& el) override {
-                auto& uml_element = dynamic_cast<UmlManager::Implementation<Element>&>(el);
-                for (auto& applied_stereotype: uml_element.getAppliedStereotypes()) {
-                    // get meta_manager from applied stereotype owning package
-                    auto& meta_manager = m_meta_managers.at(applied_stereotype.getOwningPackage().id());
-                    
-                    // release stereotype data so no hanging bad memory is still in use
-                    auto& meta_element = *meta_manager.get(applied_stereotype.getID());
-                    meta_manager.release(meta_element);
+                // release stereotype data so no hanging bad memory is still in use, data that is
+                // not loaded has nothing to release
+                for (auto& applied_pair : applied_meta_elements(el.getID())) {
+                    auto& meta_manager = m_meta_managers.at(applied_pair.first);
+                    if (meta_manager.loaded(applied_pair.second)) {
+                        meta_manager.release(*meta_manager.get(applied_pair.second));
+                    }
                 }
             
                 // call super
                 BaseManager::release(el);
             }
 
+            // bring the uml instances mirroring meta elements up to date with their meta elements
+            void sync_meta_managers() {
+                for (auto& meta_manager_pair : m_meta_managers) {
+                    meta_manager_pair.second.sync_uml_representations();
+                }
+            }
+
             std::string dump_individual(EGM::AbstractElement& el) {
                 return this->emitIndividual(el);
             }
@@ -27,6 +27,8 @@ namespace UML {
         UmlManager::Pointer<InstanceSpecification> uml_representation;
         UmlManager::Pointer<Classifier> meta_type;
         UmlManager::Pointer<Element> applying_element;
+        // names of the properties keyed by property id, shared by all meta elements of the same meta type
+        std::unordered_map<EGM::ID, std::string>* property_names = 0;
         using Set = MetaElementSet<ManagerPolicy, EGM::Set>;
         using OrderedSet = MetaElementSet<ManagerPolicy, EGM::OrderedSet>;
         using Singleton = MetaElementSet<ManagerPolicy, EGM::Singleton>;
@@ -62,13 +64,23 @@ namespace EGM {
         static std::string name() {
             return "MetaElement";
         }
+        // name of the property for the meta element, resolved from the meta type's property name table 
+        // and only looked up in the uml manager if the table is missing it
+        template <class Policy>
+        static const std::string& property_name(UML::MetaElement<Policy>& el, ID property_id) {
+            auto name_match = el.property_names->find(property_id);
+            if (name_match != el.property_names->end()) {
+                return name_match->second;
+            }
+            UML::UmlManager::Pointer<UML::Property> prop = get_element_from_uml_manager(&el, property_id);
+            return el.property_names->emplace(property_id, prop->getName()).first->second;
+        }
         template <class Policy>
         static SetList sets(UML::MetaElement<Policy>& el) {
             SetList ret;
             ret.reserve(el.sets.size());
             for (auto& pair : el.sets) {
-                UML::UmlManager::Pointer<UML::Property> prop = get_element_from_uml_manager(&el, pair.first);
-                ret.push_back(make_set_pair(prop->getName().c_str(), *pair.second));
+                ret.push_back(make_set_pair(property_name(el, pair.first).c_str(), *pair.second));
             }
             return ret;
         }
@@ -78,8 +90,7 @@ namespace EGM {
             MetaElementDataList ret;
             ret.reserve(el.data.size());
             for (auto& pair : el.data) {
-                UML::UmlManager::Pointer<UML::Property> prop = get_element_from_uml_manager(&el, pair.first);
-                ret.push_back(std::make_pair<std::string, AbstractDataPolicy*>(prop->getName(), pair.second.get()));
+                ret.push_back(std::make_pair<std::string, AbstractDataPolicy*>(std::string(property_name(el, pair.first)), pair.second.get()));
             }
             return ret;
         }
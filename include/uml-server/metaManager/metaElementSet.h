@@ -95,6 +95,7 @@ namespace UML {
     };
 
     UmlManager::Pointer<UML::Element> get_element_from_uml_manager(EGM::AbstractElementPtr ptr, EGM::ID id);
+    void mark_uml_representation_stale(EGM::AbstractElementPtr ptr);
 
     // policy to put in all of the meta element sets, keeps track of
     // the uml implementation as the set is added and removed from
@@ -110,9 +111,17 @@ namespace UML {
                 auto inst_val = uml_manager->create<InstanceValue>();
                 inst_val->setInstance(uml_manager->abstractGet(el.getID()));
                 uml_slot->getValues().add(inst_val);
+            } else {
+                // restored without its uml representation, let the meta manager sync it later
+                mark_uml_representation_stale(&me);
             }
         }
         void elementRemoved(MetaElementImpl& el, MetaElementImpl& me) {
+            if (!uml_slot) {
+                mark_uml_representation_stale(&me);
+                return;
+            }
+
             // update slot
             UmlManager::Pointer<InstanceValue> val_match;
             for (auto& val : uml_slot->getValues()) {
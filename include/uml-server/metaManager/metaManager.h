@@ -2,6 +2,14 @@
 
 #include "metaElementSet.h"
 #include "proxyElement.h"
+#include <limits>
+#include <filesystem>
+#include <list>
+
+// default amount of meta elements loaded at once while dumping a meta manager
+#define META_MANAGER_DUMP_CHUNK_SIZE 200
+// default amount of released meta elements whose serialized form is kept in memory, the rest are written to disk
+#define META_MANAGER_RECORD_LIMIT 1000
 
 namespace UML {
 
@@ -22,8 +30,30 @@ namespace UML {
         EGM::AbstractElementPtr loadElement(EGM::ID id);
         void saveElement(EGM::AbstractElement& el);
         void eraseEl(EGM::ID id);
+        ~MetaElementStoragePolicy();
         protected:
             MetaManager* m_meta_manager;
+
+            // native form of a released meta element, its individual json emit along with the
+            // applying element which is not part of the emit, references are resolved lazily on load.
+            // Only the most recently released are kept in memory, the data of the rest is in a file of its own
+            struct SerializedMetaElement {
+                EGM::ID applying_element = EGM::ID::nullID();
+                std::string data;
+                bool on_disk = false;
+                std::list<EGM::ID>::iterator in_memory;
+            };
+            std::unordered_map<EGM::ID, SerializedMetaElement> m_serialized_meta_elements;
+            std::list<EGM::ID> m_records_in_memory; // most recently released first
+            std::size_t m_record_limit = META_MANAGER_RECORD_LIMIT;
+            std::filesystem::path m_record_directory; // made the first time a record is written out
+
+            std::filesystem::path record_path(EGM::ID id);
+            // write the data of the oldest records in memory out until there are no more than m_record_limit
+            void spill_records();
+            void forget_record(std::unordered_map<EGM::ID, SerializedMetaElement>::iterator record);
+
+            EGM::AbstractElementPtr load_from_uml_representation(EGM::ID id);
     };
 
     class MetaManager : public EGM::Manager<EGM::TemplateTypeList<MetaElement, ProxyElement>, MetaElementStoragePolicy>, public MetaElementSerializationPolicy {
@@ -48,26 +78,74 @@ namespace UML {
             std::unordered_map<std::size_t, UmlManager::Pointer<Classifier>> m_uml_types;
             std::unordered_map<EGM::ID, std::size_t> m_id_to_type;
             std::unordered_map<std::string, std::size_t> m_name_to_type;
+            std::unordered_map<std::size_t, std::unordered_map<EGM::ID, std::string>> m_property_names;
             std::unordered_set<EGM::ID> m_meta_elements;
             std::unordered_map<EGM::ID, UmlManager::Pointer<Element>> m_stereotyped_elements;
             std::unordered_map<EGM::ID, ProxyElementPtr> m_proxy_elements;
+            std::unordered_map<EGM::ID, EGM::ID> m_proxied_elements; // proxy element -> uml element
+            std::vector<EGM::ID> m_new_proxy_elements;
+            std::unordered_set<EGM::ID> m_stale_uml_representations;
+
+            // resident index of stereotype applications, kept across release so tearing down an
+            // element never has to load its applied stereotypes to find them
+            std::unordered_map<EGM::ID, std::vector<EGM::ID>> m_applied_meta_elements; // applying element -> meta elements
+            std::unordered_map<EGM::ID, EGM::ID> m_applying_elements; // meta element -> applying element
+
+            std::list<UmlManager::Pointer<Element>> m_discovery_queue;
+            // every element discovery walked, kept so rediscovery only walks what changed since
+            std::unordered_set<EGM::ID> m_discovered;
+            std::unordered_set<EGM::ID> m_changed_since_discovery;
+            std::size_t m_next_type = 0;
+
+            // types restored from a saved table whose classifier has not been compared with the shape it was saved
+            // with yet, see check_type
+            std::unordered_map<std::size_t, std::string> m_unchecked_shapes;
+            bool m_table_unwalked = false; // the table was loaded and the profile never walked since
 
         public:
-            MetaManager(UmlManager::Implementation<Element>& abstraction_root);
-            std::optional<std::size_t> get_type_by_name(std::string name) { 
-                auto match = m_name_to_type.find(name);
-                if (match != m_name_to_type.end()) {
-                    return match->second;
-                }
-                return std::nullopt;
-            }
-            std::optional<std::size_t> get_type_with_id(EGM::ID id) const { 
-                auto match = m_id_to_type.find(id); 
-                if (match != m_id_to_type.end()) {
-                    return match->second;
-                }
-                return std::nullopt;
-            }
+            // abstraction_root - root of the uml elements to make types from
+            // defer_discovery - leave discovering the types to calls to discover_types
+            MetaManager(UmlManager::Implementation<Element>& abstraction_root, bool defer_discovery = false);
+
+            // discover_types
+            // max_steps - max number of elements under the generation root to visit before returning
+            // return - true once every element reachable from the generation root has been visited
+            bool discover_types(std::size_t max_steps = std::numeric_limits<std::size_t>::max());
+
+            // walk what changed since the last discovery on the next discover_types so classifiers added since
+            // extend this manager, types already known keep their element type
+            void rediscover_types();
+            // element_changed
+            // element_id - element added or changed in the uml manager
+            // owner_id - its owner, a new element is found through the walked owner it was added to
+            void element_changed(EGM::ID element_id, EGM::ID owner_id);
+            void element_erased(EGM::ID element_id);
+            bool discovering_types() const { return !m_discovery_queue.empty(); }
+            std::size_t num_types() const { return m_uml_types.size(); }
+
+            // hash over the type table, the id and shape (name, attributes with their names and types, and
+            // generals) of the classifier of every type, used to tell whether a saved type table is the one
+            // saved with it. Only loads the classifiers of types that were used
+            std::string profile_hash();
+
+            // rename_property
+            // property_id - property of the profile whose name changed, its meta elements emit it under name from now on
+            void rename_property(EGM::ID property_id, const std::string& name);
+
+            // emit the compiled type tables as a sequence so they can be restored without discovery
+            void emit_type_table(YAML::Emitter& emitter);
+
+            // load_type_table
+            // types_node - sequence emitted by emit_type_table
+            // expected_hash - profile_hash at the time the table was emitted
+            // return - false if the table is not the one hashed, the manager is left without types. Nothing of
+            //          the profile is loaded, each classifier is checked the first time its type is used
+            bool load_type_table(YAML::Node types_node, std::string expected_hash);
+
+            // get_type_by_name and get_type_with_id walk the profile if the type is not in a loaded table,
+            // it may have been added since the table was saved
+            std::optional<std::size_t> get_type_by_name(std::string name);
+            std::optional<std::size_t> get_type_with_id(EGM::ID id);
             UmlManager::Pointer<Element> get_stereotyped_element(EGM::ID id) const {
                 auto match = m_stereotyped_elements.find(id);
                 if (match != m_stereotyped_elements.end()) {
@@ -76,14 +154,64 @@ namespace UML {
                 return UmlManager::Pointer<Element>();
             }
             UmlManager::Pointer<Element> get_generation_root() const { return m_generation_root; }
+
+            // ids of the meta elements applied as stereotypes to a uml element, nothing is loaded
+            const std::vector<EGM::ID>& get_applied_meta_elements(EGM::ID applying_element_id) const {
+                static const std::vector<EGM::ID> none;
+                auto match = m_applied_meta_elements.find(applying_element_id);
+                if (match != m_applied_meta_elements.end()) {
+                    return match->second;
+                }
+                return none;
+            }
+
+            // limit - max released meta elements whose serialized form is kept in memory
+            void set_record_limit(std::size_t limit) {
+                m_record_limit = limit;
+                spill_records();
+            }
+
+            // mark the uml instance representing a meta element as out of date with the meta element
+            void mark_uml_representation_stale(EGM::ID id) {
+                m_stale_uml_representations.insert(id);
+            }
+
+            // bring the uml instances of meta elements that changed while their sets were not linked
+            // to a slot back up to date, meant to be run off of the path handling requests
+            void sync_uml_representations();
         private:
+            // check_type
+            // type - type restored from a saved table, if its classifier changed since it was saved the name and
+            //        property names of the type are taken from the classifier and the profile is walked for what
+            //        it now reaches. Generals are checked too, they lay out meta elements of this type
+            void check_type(std::size_t type);
+            // discover every type from the generation root once after loading a table, types keep their element type
+            void walk_loaded_table();
+            std::string type_shape(std::size_t type);
+            // the classifier of a type, checked first
+            UmlManager::Pointer<Classifier> uml_type(std::size_t type);
+            // every typed attribute a meta element of element_type has, its own and those of its generals
+            std::vector<UmlManager::Pointer<Property>> typed_attributes(std::size_t element_type);
             // create_meta_element
             // element_type - element_type of meta_element
             // applying_element - pointer (can be null) to element applying meta_element to as stereotype
+            // attributes - typed_attributes of element_type if already walked, walked for this element if null
             // return - the meta_element created as a ptr
-            BaseManager::Pointer<MetaElement> create_meta_element_object(std::size_t element_type, UmlManager::Pointer<Element> applying_element);
-            EGM::AbstractElementPtr create_meta_element(std::size_t element_type, UmlManager::Pointer<Element> applying_element);
+            BaseManager::Pointer<MetaElement> create_meta_element_object(
+                std::size_t element_type, 
+                UmlManager::Pointer<Element> applying_element, 
+                const std::vector<UmlManager::Pointer<Property>>* attributes = 0
+            );
+            EGM::AbstractElementPtr create_meta_element(
+                std::size_t element_type, 
+                UmlManager::Pointer<Element> applying_element, 
+                const std::vector<UmlManager::Pointer<Property>>* attributes = 0
+            );
             void create_uml_representation(BaseManager::Pointer<MetaElement> meta_element);
+            MetaElementPtr restore_meta_element(UmlManager::Pointer<Element> applying_element, std::string& data);
+            void sync_uml_representation(MetaElementPtr meta_element);
+            void index_application(EGM::ID meta_element_id, EGM::ID applying_element_id);
+            void unindex_application(EGM::ID meta_element_id);
             EGM::ID next_id; // id used for create
         public:
 
@@ -99,13 +227,33 @@ namespace UML {
                 ProxyElementPtr proxy_element = BaseManager::create<ProxyElement>();
                 proxy_element->m_uml_element = el;
                 m_proxy_elements.emplace(el.id(), proxy_element);
+                m_proxied_elements.emplace(proxy_element.id(), el.id());
+                m_new_proxy_elements.push_back(proxy_element.id());
                 return proxy_element;
             }
 
+            // ids of the proxy elements created since the last call, for residency accounting
+            std::vector<EGM::ID> take_new_proxy_elements() {
+                std::vector<EGM::ID> ret;
+                ret.swap(m_new_proxy_elements);
+                return ret;
+            }
+
+            // release_resident
+            // release a meta element along with the uml instance mirroring it, or a proxy element
+            // id - id of the meta element or proxy element, nothing happens if it is not loaded
+            void release_resident(EGM::ID id);
+
             EGM::AbstractElementPtr reindex(EGM::ID oldID, EGM::ID newID) override {
                 MetaElementPtr meta_element = BaseManager::reindex(oldID, newID);
                 m_meta_elements.erase(oldID);
                 m_meta_elements.insert(newID);
+                auto applying_match = m_applying_elements.find(oldID);
+                if (applying_match != m_applying_elements.end()) {
+                    EGM::ID applying_element_id = applying_match->second;
+                    unindex_application(oldID);
+                    index_application(newID, applying_element_id);
+                }
 
                 // delete old instance, and set it up again with new id
                 UmlManager::Pointer<InstanceSpecification> overwritten_element = m_storage_root->getPackagedElements().get(newID);
@@ -121,7 +269,7 @@ namespace UML {
             }
 
             MetaElementPtr create(EGM::ID id) {
-                return create(m_id_to_type.at(id));
+                return create(get_type_with_id(id).value());
             }
 
             MetaElementPtr create(EGM::ID type_id, EGM::ID element_id) {
@@ -135,7 +283,7 @@ namespace UML {
             }
 
             MetaElementPtr apply(UmlManager::Implementation<Element>& el, EGM::ID stereotype_id) {
-                return apply(el, m_id_to_type.at(stereotype_id));
+                return apply(el, get_type_with_id(stereotype_id).value());
             }
 
             MetaElementPtr apply(UmlManager::Implementation<Element>& el, EGM::ID stereotype_id, EGM::ID element_id) {
@@ -148,6 +296,13 @@ namespace UML {
                 return apply(el, stereotype_type);
             }
 
+            // apply_all
+            // apply the same stereotype to many elements at once
+            // applying_elements - elements to apply the stereotype to, must all be loaded
+            // stereotype_type - element_type of the stereotype
+            // return - the created meta_elements in the same order as applying_elements
+            std::vector<MetaElementPtr> apply_all(std::vector<UmlManager::Pointer<Element>>& applying_elements, std::size_t stereotype_type);
+
             EGM::ManagerTypes<UmlTypes>& getUmlManager() const {
                 return m_uml_manager;
             }
@@ -166,24 +321,24 @@ namespace UML {
 
             MetaElementPtr parse_stereotype_node(UmlManager::Implementation<Element>& el, YAML::Node node);
 
-            void dump_all_data(YAML::Emitter& emitter) {
+            // visit_all_data
+            // visit - called in order with every meta element
+            // chunk_size - max number of meta elements loaded at once, elements that were not in memory
+            //              before the visit are released once their chunk is visited
+            void visit_all_data(std::function<void(BaseManager::Implementation<MetaElement>&)> visit, std::size_t chunk_size = META_MANAGER_DUMP_CHUNK_SIZE);
+
+            // stream_all_data
+            // consume - called in order with the individual json emit of every meta element
+            // chunk_size - see visit_all_data
+            void stream_all_data(std::function<void(std::string&)> consume, std::size_t chunk_size = META_MANAGER_DUMP_CHUNK_SIZE);
+
+            void dump_all_data(YAML::Emitter& emitter, std::size_t chunk_size = META_MANAGER_DUMP_CHUNK_SIZE) {
                 emitter << YAML::BeginSeq;
-                for (auto id : m_meta_elements) {
-                    MetaElementPtr meta_element = get(id);
+                visit_all_data([this, &emitter](BaseManager::Implementation<MetaElement>& meta_element) {
                     emitter << YAML::BeginMap;
-                    FindValidScopeVisitor scope_visitor { meta_element };
-                    scope_visitor.visit<MetaElement>();
-                    if (scope_visitor.validMatch) {
-                        emitter << YAML::Key << scope_visitor.validMatch->first;
-                        emitter << YAML::Value << (*scope_visitor.validMatch->second->beginPtr()).getCurr().id().string();
-                    }
-                    emitter << YAML::Key << meta_element->name;
-                    emitter << YAML::Value << YAML::BeginMap;
-                    emitter << YAML::Key << "id" << YAML::Value << id.string();
-                    EmitVisitor visitor { meta_element, emitter };
-                    visitor.visit<MetaElement>();
+                    emit_meta_element(emitter, meta_element);
                     emitter << YAML::EndMap;
-                }
+                }, chunk_size);
                 emitter << YAML::EndSeq;
             }
     };
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "egm/id.h"
+#include <map>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace UML {
+
+    // NameIndex
+    // inverted index over the names of elements, by full name and by the words in a name
+    // ("fooBar baz" is found by foo, bar and baz). Keys are lowercase and kept ordered so both
+    // exact and prefix lookups are a single range of the index, case sensitive lookups filter that
+    // range with the original names
+    class NameIndex {
+        public:
+            enum class SearchMode {
+                EXACT,
+                PREFIX
+            };
+        private:
+            using IdsByKey = std::map<std::string, std::unordered_set<EGM::ID>, std::less<>>;
+            std::unordered_map<EGM::ID, std::string> m_names;
+            IdsByKey m_by_name;
+            IdsByKey m_by_token;
+
+            static std::string to_lower(std::string_view str);
+            static std::vector<std::string> tokenize(std::string_view name);
+            static void remove_key(IdsByKey& ids_by_key, const std::string& key, EGM::ID id);
+        public:
+            // index the name of an element, replaces the name it was indexed with before
+            void index(EGM::ID id, std::string name);
+            void unindex(EGM::ID id);
+            void clear();
+
+            // search
+            // query - name or beginning of a name to search for
+            // mode - whether names must match query completely or only start with it
+            // case_sensitive - whether case must match, matches with the same case rank first either way
+            // limit - max number of ids to return
+            // return - the best ranked ids, exact matches first, then names starting with query, then names
+            //          with a word starting with query, in order of name within each rank (of the word for the last)
+            std::vector<EGM::ID> search(std::string_view query, SearchMode mode, bool case_sensitive, std::size_t limit) const;
+    };
+}
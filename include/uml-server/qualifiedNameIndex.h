@@ -0,0 +1,81 @@
+#pragma once
+
+#include "egm/id.h"
+#include <functional>
+#include <map>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace UML {
+
+    // QualifiedNameIndex
+    // index of element ids by qualified name, built from the ownership tree of the elements under a root.
+    // Elements are kept by id along with their owner and name so renames and moves only touch the
+    // entries of the element moved, what it owns follows it, and lookups walk one map per segment of the path
+    class QualifiedNameIndex {
+        public:
+            static constexpr std::string_view SEPARATOR = "::";
+        private:
+            struct Entry {
+                EGM::ID owner = EGM::ID::nullID();
+                std::string name;
+                bool indexed = false; // false if this entry only exists to hold children of an unindexed owner
+                std::map<std::string, std::unordered_set<EGM::ID>, std::less<>> children;
+            };
+
+            EGM::ID m_root = EGM::ID::nullID();
+            std::unordered_map<EGM::ID, Entry> m_entries;
+
+            void detach(EGM::ID id, Entry& entry);
+            void erase_subtree(EGM::ID id);
+            const Entry* find_entry(std::vector<std::string_view>& segments) const;
+            static std::vector<std::string_view> split(std::string_view qualified_name);
+        public:
+            // set the element qualified names are resolved from, its qualified name is its own name,
+            // "" looks it up as well
+            void set_root(EGM::ID root_id, std::string name);
+            EGM::ID get_root() const { return m_root; }
+
+            // index an element or update the entry of one already indexed after a rename or move
+            // id - id of the element
+            // name - name of the element, empty for elements that are not named
+            // owner - id of the owner of the element, null if it has none
+            void index(EGM::ID id, std::string name, EGM::ID owner);
+
+            // remove an element and everything owned by it from the index
+            void unindex(EGM::ID id);
+
+            void clear();
+
+            bool contains(EGM::ID id) const;
+
+            // return - owner id is indexed under, null if it has none, nullopt if id is not indexed
+            std::optional<EGM::ID> owner_of(EGM::ID id) const;
+
+            // return - true if ancestor is one of the owners of id, directly or through its owners
+            bool owned_by(EGM::ID id, EGM::ID ancestor) const;
+
+            // call f with every element id owns, directly or through what it owns
+            void for_each_owned(EGM::ID id, std::function<void(EGM::ID)> f) const;
+
+            // lookup
+            // qualified_name - names of the root and the owners of the element separated by "::"
+            // return - id of the element, nullopt if there is none or the name is ambiguous
+            std::optional<EGM::ID> lookup(std::string_view qualified_name) const;
+
+            // lookup_prefix
+            // prefix - qualified name with a partial last segment, a prefix ending in "::" matches
+            //          everything owned by the element it names
+            // limit - max number of ids to return
+            // return - ids of the elements whose qualified name starts with prefix, ordered by name
+            std::vector<EGM::ID> lookup_prefix(std::string_view prefix, std::size_t limit) const;
+
+            // return - qualified name of an indexed element, the one lookup finds it by, nullopt if it is not
+            //          reachable from the root
+            std::optional<std::string> qualified_name(EGM::ID id) const;
+    };
+}
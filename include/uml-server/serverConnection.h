@@ -0,0 +1,92 @@
+#pragma once
+
+#include "egm/id.h"
+#include <condition_variable>
+#include <cstdint>
+#include <future>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+
+namespace UML {
+
+    // messages the server pushed to a client without being asked, handed to the thread using the client
+    struct PushedMessages {
+        std::list<std::string> messages;
+        bool connection_lost = false;
+        std::mutex mtx;
+        std::condition_variable cv;
+    };
+
+    // ServerConnection
+    // socket to a UmlServer along with the thread reading everything sent over it. Replies are matched to
+    // requests by correlation id, so one connection can be shared by many clients, each attached to the
+    // server under its own id
+    class ServerConnection {
+        private:
+            int m_socketD = 0;
+            const EGM::ID m_id;
+            std::string m_server_info; // meta managers the server listed in the handshake
+            bool m_shared_memory = false; // big replies come through memfds passed over the unix domain socket
+
+            // correlation id of the next request, the server wraps the reply to it as {"rid":n,"reply":reply}
+            std::uint64_t m_next_request_id = 1;
+            std::unordered_map<std::uint64_t, std::promise<std::string>> m_pending_replies;
+            bool m_connection_lost = false;
+            std::mutex m_pendingMtx;
+            std::mutex m_sendMtx; // keeps requests from interleaving on the socket
+
+            // where pushed messages go by the client they are for, messages pushed to clients attached to the
+            // connection come wrapped as {"to":id,"message":message}
+            std::unordered_map<EGM::ID, PushedMessages*> m_routes;
+            std::mutex m_routesMtx;
+
+            std::thread m_reader;
+            void connect_tcp(std::string address, int port);
+            void connect_unix(std::string path);
+            void handshake(bool unix_socket);
+            void read_replies();
+            void push(EGM::ID client_id, std::string message);
+        public:
+            // addresses starting with this name the path of a unix domain socket the server listens on, the port
+            // is ignored for them
+            static constexpr std::string_view UNIX_ADDRESS_PREFIX = "unix:";
+
+            // connect and run the handshake under id
+            ServerConnection(std::string address, int port, EGM::ID id = EGM::ID::randomID());
+            ServerConnection(const ServerConnection&) = delete;
+            ServerConnection& operator=(const ServerConnection&) = delete;
+            ~ServerConnection();
+
+            EGM::ID id() const { return m_id; }
+            const std::string& server_info() const { return m_server_info; }
+            bool shared_memory() const { return m_shared_memory; }
+
+            // request_async
+            // request - json map of the request
+            // client - id of the attached client making the request, nullopt if it is the connection's own
+            // return - future that is ready once the reply to the request comes in
+            std::future<std::string> request_async(std::string request, std::optional<EGM::ID> client = std::nullopt);
+
+            // hand messages pushed to client_id to pushed until unrouted
+            void route(EGM::ID client_id, PushedMessages& pushed);
+            void unroute(EGM::ID client_id);
+
+            // address clients connect to when they are not given one, empty is the local host over tcp
+            static void set_default_address(std::string address);
+            static std::string default_address();
+
+            // share_connections
+            // num_connections - number of connections clients created from now on are spread over, 0 gives each
+            //                   client a connection of its own
+            static void share_connections(std::size_t num_connections);
+            // return - connection for the next client to attach to out of the ones to address and port, null if
+            //          connections are not shared
+            static std::shared_ptr<ServerConnection> shared(std::string address, int port);
+    };
+}
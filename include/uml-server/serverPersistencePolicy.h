@@ -1,25 +1,105 @@
 #pragma once
 #include "egm/id.h"
 #include "generativeManager.h"
+#include "serverConnection.h"
+#include <cstdint>
+#include <future>
+#include <list>
+#include <optional>
+#include <type_traits>
+#include <unordered_set>
+#include <vector>
 
 #define UML_PORT 8652
 #define UML_CLIENT_MSG_SIZE 200
+#define UML_CLIENT_CACHE_SIZE 0
+#define UML_CLIENT_UNCACHE_BATCH 64
 
 namespace YAML {
     class Emitter;
 }
 
 namespace UML {
+
+    // change to an element the client subscribed to, pushed by the server
+    struct ChangeNotification {
+        std::string kind; // post, put or delete
+        EGM::ID id;
+        std::string type;
+        std::string body; // emit of the element after the change if the subscription asked for bodies
+    };
+
+    enum class SubscriptionScope {
+        ELEMENT,
+        SUBTREE
+    };
+
     class ServerPersistencePolicy : virtual public AbstractGenerativeManager {
         protected:
-            std::string m_address;
+            std::string m_address = ServerConnection::default_address();
             int m_port = UML_PORT;
-            int m_socketD = 0;
             const EGM::ID clientID = EGM::ID::randomID();
 
             std::function<void()> m_initialization_procedure;
 
-            void sendEmitter(int socket, YAML::Emitter& emitter);
+            // connection to the server, of our own or shared with other clients we are attached to it under clientID
+            std::shared_ptr<ServerConnection> m_connection;
+            bool m_attached = false;
+            // messages the server pushed to us, set aside by the connection for the thread using the client
+            mutable PushedMessages m_pushed;
+
+            // requests sent while this is set are not waited on, the futures of their replies go in here
+            std::vector<std::future<std::string>>* m_async_acks = 0;
+
+            // send a request, the future is ready once the reply to it comes in
+            std::future<std::string> request_async(std::string request);
+            // send a request and wait for the reply to it
+            std::string request(std::string request);
+            std::string request(YAML::Emitter& emitter);
+            // return - the reply, after checking it has a success status
+            static std::string check_reply(std::string reply);
+            static void wait_for_acks(std::vector<std::future<std::string>>& acks);
+
+            // without_waiting
+            // f - function making requests, e.g. creating or releasing an element
+            // return - deferred future of what f returns, getting it waits on the replies to the requests f made
+            template <class F>
+            auto without_waiting(F f) {
+                using Result = decltype(f());
+                std::vector<std::future<std::string>> acks;
+                m_async_acks = &acks;
+                if constexpr (std::is_void_v<Result>) {
+                    try {
+                        f();
+                    } catch (...) {
+                        m_async_acks = 0;
+                        throw;
+                    }
+                    m_async_acks = 0;
+                    return std::async(std::launch::deferred, [acks = std::move(acks)]() mutable {
+                        wait_for_acks(acks);
+                    });
+                } else {
+                    std::optional<Result> result;
+                    try {
+                        result.emplace(f());
+                    } catch (...) {
+                        m_async_acks = 0;
+                        throw;
+                    }
+                    m_async_acks = 0;
+                    return std::async(std::launch::deferred, [acks = std::move(acks), result = std::move(*result)]() mutable {
+                        wait_for_acks(acks);
+                        return result;
+                    });
+                }
+            }
+
+            // GET request for an element, versioned if we are caching
+            std::string get_request(EGM::ID id) const;
+            // record the body of an element from the reply to its get request
+            // return - the body
+            std::string accept_element(EGM::ID id, std::string reply);
             std::string loadElementData(EGM::ID id);
             void saveElementData(std::string data, EGM::ID id);
             std::string getProjectData(std::string path);
@@ -30,11 +110,90 @@ namespace UML {
             EGM::AbstractElementPtr reindex(EGM::ID oldID, EGM::ID newID) override;
             void create_storage(EGM::AbstractElement& el);
 
-            void receive_and_check_reply() const;
+            // body of each element as the server last saw it, so saves only send what changed,
+            // along with the version the server gave it
+            struct SentElement {
+                std::string body;
+                std::uint64_t version = 0;
+            };
+            mutable std::unordered_map<EGM::ID, SentElement> m_last_sent;
+
+            // ids of released elements whose last sent body is kept so getting them again needs no request,
+            // most recently released first. The server invalidates them when another client changes them
+            std::size_t m_cache_size = UML_CLIENT_CACHE_SIZE;
+            mutable std::list<EGM::ID> m_cache;
+            mutable std::unordered_map<EGM::ID, std::list<EGM::ID>::iterator> m_cache_entries;
+
+            // cache_element
+            // keep the last sent body of an element for when it is gotten again, the most recently cached
+            // element is kept even if the cache size is 0 so the next load can take it
+            void cache_element(EGM::ID id) const;
+            // retire_sent
+            // called once an element being released is saved, caches its body or drops it so the last sent
+            // bodies only grow with what is loaded and cached
+            void retire_sent(EGM::ID id) const;
+            void invalidate(EGM::ID id) const;
+            // forget_sent
+            // drop the last sent body of an element, the server stops tracking it for us once nothing of it is left
+            void forget_sent(EGM::ID id) const;
+            // ids forgotten since the server was last told, sent UML_CLIENT_UNCACHE_BATCH at a time
+            mutable std::unordered_set<EGM::ID> m_uncached;
+            void flush_uncached();
+            // directory elements are kept in between runs, empty if there is no disk cache
+            std::string m_disk_cache_path;
+            // server the versions on disk came from, see UmlServer::m_epoch
+            std::string m_server_epoch;
+            // versions of the elements in the disk cache when it was opened, and the ones not loaded yet
+            std::unordered_map<EGM::ID, std::uint64_t> m_disk_versions;
+            mutable std::unordered_map<EGM::ID, std::uint64_t> m_disk_cache;
+            bool caching() const { return m_cache_size || !m_disk_cache_path.empty(); }
+            void write_disk_cache();
+
+            // id each qualified name resolved to last time, so getting it again only needs its version checked
+            std::unordered_map<std::string, EGM::ID> m_qualified_name_ids;
+            // resolve_qualified_name
+            // return - id of the element with the qualified name, its body is cached if the server sent it
+            EGM::ID resolve_qualified_name(std::string qualified_name);
+
+            // handle a message the server pushed without being asked, return false if it is not one
+            bool handle_pushed(std::string& message) const;
+            // handle everything the server pushed since the last time
+            void drain_pushed() const;
+
+            // notifications pushed by the server, handed out by next_notification
+            mutable std::list<std::string> m_notifications;
+
+            void send_subscription(std::string request_name, std::string scope, std::string value, bool bodies);
 
             ServerPersistencePolicy();
         public:
             void mount(std::string mountPath);
+
+            // set_cache_size
+            // size - max number of released elements to keep around, 0 turns caching off
+            void set_cache_size(std::size_t size);
+            std::size_t get_cache_size() const { return m_cache_size; }
+            // return - true if the element is released and would be gotten without a request
+            bool cached(EGM::ID id) const;
+
+            // open_disk_cache
+            // path - directory to keep the last sent body of elements in when the client is destroyed,
+            //        whatever is already in it is checked against the server in one request and the
+            //        elements still up to date are gotten from disk
+            void open_disk_cache(std::string path);
+
+            // subscribe to changes other clients make to an element, or to anything under it
+            void subscribe(EGM::ID id, SubscriptionScope scope = SubscriptionScope::ELEMENT, bool bodies = false);
+            // subscribe to changes other clients make to any element of a type
+            void subscribe(std::string type_name, bool bodies = false);
+            void unsubscribe(EGM::ID id, SubscriptionScope scope = SubscriptionScope::ELEMENT);
+            void unsubscribe(std::string type_name);
+
+            // next_notification
+            // timeout_ms - how long to wait for a notification if none has been received yet
+            // return - the oldest notification not handed out yet, nullopt if none came in time
+            std::optional<ChangeNotification> next_notification(int timeout_ms = 0);
+
             virtual ~ServerPersistencePolicy();
     };
 }
@@ -15,6 +15,29 @@ namespace UML {
             BaseManager::Pointer<Element> get(EGM::ID id) {
                 return BaseManager::get(id);
             }
+            // get an element along with the elements it owns down to depth in one request
+            BaseManager::Pointer<Element> get(EGM::ID id, std::size_t depth);
+
+            // asynchronous versions of get, create, release and erase. The request is sent right away so many
+            // can be in flight at once, the future is ready once the reply comes in. Getting the future touches
+            // the client so it must be done on the thread using the client
+            std::future<BaseManager::Pointer<Element>> get_async(EGM::ID id);
+            template <class T = Element>
+            std::future<BaseManager::Pointer<T>> create_async() {
+                return without_waiting([this] {
+                    return BaseManager::template create<T>();
+                });
+            }
+            std::future<void> release_async(Element& el) {
+                return without_waiting([this, &el] {
+                    BaseManager::release(el);
+                });
+            }
+            std::future<void> erase_async(Element& el) {
+                return without_waiting([this, &el] {
+                    BaseManager::erase(el);
+                });
+            }
             void setRoot(EGM::AbstractElementPtr root) override;
     };
 }
@@ -1,12 +1,19 @@
 #pragma once
 
 #include "generativeManager.h"
+#include "qualifiedNameIndex.h"
+#include "elementTypeIndex.h"
+#include "backlinkIndex.h"
+#include "nameIndex.h"
+#include "workerPool.h"
 
 #include <atomic>
 #include <iostream>
 #include <mutex>
+#include <shared_mutex>
 #include <condition_variable>
 #include <optional>
+#include <vector>
 #ifdef WIN32
 #include "winsock2.h"
 #include <ws2tcpip.h>
@@ -18,7 +25,22 @@ typedef int socketType;
 
 #define UML_PORT 8652
 #define UML_SERVER_MSG_SIZE 200
+#define UML_SERVER_BACKLOG 10
+#define UML_SERVER_HANDSHAKE_TIMEOUT 5000
+#define UML_SERVER_WORKERS 0 // 0 is a worker per hardware thread
 #define UML_SERVER_NUM_ELS 200
+#define UML_SERVER_META_DUMP_SHARE 4 // saving a meta manager loads at most this fraction of the element limit at once
+#define UML_SERVER_GENERATION_STEP 100
+#define UML_SERVER_SYNC_INTERVAL 100 // ms between tries to update stale uml mirrors of meta elements
+#define UML_SERVER_LOOKUP_LIMIT 100
+#define UML_SERVER_QUERY_LIMIT 1000
+#define UML_SERVER_SEARCH_LIMIT 50
+#define UML_SERVER_SUBTREE_LIMIT 1000
+#define UML_SERVER_SHARED_MEMORY_MIN 65536
+#define UML_SERVER_IO_URING_ENTRIES 256
+#define UML_SERVER_IO_URING_BUFFERS 64
+#define UML_SERVER_IO_URING_BUFFER_SIZE 65536
+#define UML_SERVER_IO_URING_SEND_BUFFERS 64
 
 namespace std {
     class thread;
@@ -28,6 +50,15 @@ namespace UML {
 
     void send_message(int socket, std::string& data);
     std::optional<std::string> receive_message(int socket);
+    #ifdef __linux__
+    // send_shared_message
+    // writes data once into a sealed memfd and passes it over a unix domain socket so the peer maps it instead
+    // of reading it through the socket buffer
+    // return - false if the memfd could not be made, nothing has been sent then
+    bool send_shared_message(int socket, std::string& data);
+    // receive_message that also takes messages sent with send_shared_message
+    std::optional<std::string> receive_any_message(int socket);
+    #endif
 
     class UmlServer : public GenerativeManager<EGM::Manager<UmlTypes, EGM::SerializedStoragePolicy<GenerativeSerializationPolicy, EGM::FilePersistencePolicy>>> {
 
@@ -35,19 +66,66 @@ namespace UML {
             friend struct UmlServerSerializationPolicy;
             using BaseManager = GenerativeManager<EGM::Manager<UmlTypes, EGM::SerializedStoragePolicy<GenerativeSerializationPolicy, EGM::FilePersistencePolicy>>>;
 
+            // what a client wants to be notified of when elements change, only touched by requests of the client itself
+            // or while holding m_messageHandlerMtx exclusively
+            struct ClientSubscriptions {
+                std::unordered_set<EGM::ID> elements;
+                std::unordered_set<EGM::ID> subtrees;
+                std::unordered_set<std::size_t> types;
+                bool bodies = false; // send the new emit of the element along with its id
+                // client caches what it gets and saves, so tell it when another client changes one of those
+                bool cache = false;
+                std::unordered_set<EGM::ID> cached;
+                bool empty() const { return elements.empty() && subtrees.empty() && types.empty() && !cache; }
+            };
+
             struct ClientInfo {
                 socketType socket;
                 std::thread* thread;
-                std::thread* handler;
+                // requests waiting on the worker pool, scheduled while a worker is on them so only one runs at a time
+                // and they are handled in the order they came in
                 std::mutex handlerMtx;
                 std::condition_variable handlerCv;
                 std::list<std::string> threadQueue;
+                bool scheduled = false;
+                std::thread::id serving;
+                bool closed = false;
+
+                // held for every frame written to the socket so replies and notifications never interleave
+                std::mutex sendMtx;
+                // client is on the same host and asked for big replies to come through shared memory
+                bool shared_memory = false;
+
+                // notifications are sent from their own thread so a slow client never holds up the handler
+                ClientSubscriptions subscriptions;
+                // clients sharing this connection, each attached under its own id
+                std::unordered_map<EGM::ID, ClientSubscriptions> attached_clients;
+                std::thread* sender = 0;
+                std::mutex outboundMtx;
+                std::condition_variable outboundCv;
+                std::list<std::string> outbound;
+                bool closing = false;
+            };
+
+            // meta manager being generated in the background, only touched while holding m_messageHandlerMtx
+            struct GenerationJob {
+                std::thread* thread = 0;
+                bool done = false;
+                std::string error;
+            };
+
+            // entry of the release queue, manager is null for elements of the uml manager
+            struct ResidentElement {
+                EGM::ID manager = EGM::ID::nullID();
+                EGM::ID id = EGM::ID::nullID();
             };
 
             int m_port = UML_PORT;
 
             //data
             const EGM::ID m_shutdownID = EGM::ID::randomID();
+            // versions only mean something within one run of the server, clients compare this before trusting them
+            const EGM::ID m_epoch = EGM::ID::randomID();
             socketType m_socketD = 
             #ifndef WIN32
             0;
@@ -55,20 +133,85 @@ namespace UML {
             INVALID_SOCKET;
             WSADATA m_wsaData;
             #endif
-            std::unordered_map<EGM::ID, ClientInfo> m_clients;
-            std::unordered_map<std::string, EGM::ID> m_urls;
-            std::list<EGM::ID> m_releaseQueue;
+            // optional unix domain socket listened to along with the tcp one, only on posix
+            std::string m_socketPath;
+            socketType m_unixSocketD = -1;
+            // held only to find, add or remove clients, a client stays alive while anyone holds its pointer
+            std::unordered_map<EGM::ID, std::shared_ptr<ClientInfo>> m_clients;
+            std::mutex m_clientsMtx;
+            // return - the client, null if it is gone
+            std::shared_ptr<ClientInfo> find_client(EGM::ID id);
+            QualifiedNameIndex m_qualified_names;
+            ElementTypeIndex m_type_index;
+            BacklinkIndex m_backlinks;
+            NameIndex m_name_index;
+            std::list<ResidentElement> m_releaseQueue;
+            std::unordered_map<EGM::ID, GenerationJob> m_generation_jobs;
+            // version of each element changed or deleted since the server started, elements not in here are at version 1
+            std::unordered_map<EGM::ID, std::uint64_t> m_versions;
+            std::uint64_t m_version_clock = 1;
             long unsigned int m_numEls = 0;
             long unsigned int m_maxEls = UML_SERVER_NUM_ELS;
 
             // threading
-            static void acceptNewClients(UmlServer* me);
+            // primary - the thread shutting down waits on, it holds m_runMtx while accepting
+            static void acceptNewClients(UmlServer* me, socketType listener, bool primary);
+            // accepted sockets are handed to the handshake thread, which runs every handshake at once over non blocking
+            // sockets so a slow client never holds up accepting or the handshakes of others
+            static void handshakeClients(UmlServer* me);
+            void queue_handshake(socketType newSocketD);
+            void wake_handshakes();
+            std::list<socketType> m_newConnections;
+            std::mutex m_handshakeMtx;
+            socketType m_handshakeWake[2] = {-1, -1}; // pipe to wake the handshake thread up, only on posix
+            std::thread* m_handshakeThread = 0;
+            int m_handshakeTimeout = UML_SERVER_HANDSHAKE_TIMEOUT;
+            // sets up the threads serving a client once its handshake is done and sends its id back
+            static void admitClient(UmlServer* me, socketType newSocketD, EGM::ID client_id);
+            // ring accepting clients and reading everything they send, only built with the io_uring backend
+            struct IoUringLoop;
+            IoUringLoop* m_ioUring = 0;
+            static void ioUringLoop(UmlServer* me);
+            void wake_io_uring();
             static void receiveFromClient(UmlServer* me, EGM::ID id);
-            static void clientSubThreadHandler(UmlServer* me, EGM::ID id);
+            void queue_request(EGM::ID id, std::string message);
+            void serveClient(EGM::ID id);
+            WorkerPool m_workers;
+            std::size_t m_numWorkers = UML_SERVER_WORKERS;
             static void garbageCollector(UmlServer* me);
             static void zombieKiller(UmlServer* me);
+            // client_id - client whose connection failed, the zombie killer removes it along with its subscriptions
+            void queue_zombie(EGM::ID client_id);
+            static void generationJob(UmlServer* me, EGM::ID manager_id);
+            static void clientSender(UmlServer* me, EGM::ID id);
             void handleMessage(EGM::ID id, std::string buff);
+            // request_id - correlation id of the request being answered, the reply is wrapped as {"rid":n,"reply":msg},
+            //              pushed messages go out untagged
+            void reply(ClientInfo& info, std::string& msg, std::optional<std::uint64_t> request_id = std::nullopt);
+            void notify_change(EGM::ID source_client, EGM::ID changed_id, std::size_t element_type, std::string kind, EGM::AbstractElement* el);
+            void queue_resident(EGM::ID manager_id, EGM::ID element_id);
+            void queue_new_proxy_elements(MetaManager& meta_manager, EGM::ID manager_id);
+            void unqueue_resident(EGM::ID element_id);
+            std::uint64_t version_of(EGM::ID id) const;
+            void track_cached(ClientSubscriptions& subscriptions, EGM::ID id);
+            std::string emit_meta_manager_list();
+            // handshakes send a copy of the list kept here so they never wait on a request, it is refreshed by
+            // whoever may have added a meta manager while still holding the handler lock exclusively
+            void refresh_meta_manager_list();
+            std::string meta_manager_list();
+            std::string m_metaManagerList = "[]";
+            std::size_t m_metaManagerListSize = 0;
+            std::mutex m_metaManagerListMtx;
+            void index_element(UmlManager::Implementation<Element>& el);
+            // appends the json array of root and what it owns down to depth to msg, at most UML_SERVER_SUBTREE_LIMIT
+            // elements and never more than the server keeps resident, returns the number of elements emitted
+            std::size_t emit_subtree(UmlManager::Pointer<Element> root, std::size_t depth, std::string& msg);
             std::thread* m_acceptThread = 0;
+            // listeners bound to the port along with m_socketD through SO_REUSEPORT, each accepted from by its own thread
+            std::size_t m_numAcceptThreads = 1;
+            int m_backlog = UML_SERVER_BACKLOG;
+            std::vector<socketType> m_reusePortSockets;
+            std::vector<std::thread*> m_reusePortThreads;
             std::thread* m_garbageCollectionThread = 0;
             std::thread* m_zombieKillerThread = 0;
             std::atomic<bool> m_running = false;
@@ -79,12 +222,17 @@ namespace UML {
             std::mutex m_shutdownMtx;
             std::condition_variable m_shutdownCv;
             bool m_shutdownV = false;
+            std::atomic<bool> m_shuttingDown = false;
+            // shuts the server down after a KILL, off the workers since shutting down stops them
+            std::thread* m_killThread = 0;
+            std::mutex m_killMtx;
             std::mutex m_garbageMtx;
             std::condition_variable m_garbageCv;
             std::list<EGM::ID> m_zombies;
             std::mutex m_zombieMtx;
             std::condition_variable m_zombieCv;
-            std::mutex m_messageHandlerMtx;
+            // held exclusively by requests changing anything, requests answered from the indices only share it
+            std::shared_mutex m_messageHandlerMtx;
             
             
 
@@ -102,6 +250,19 @@ namespace UML {
             size_t count(EGM::ID id);
             void reset();
             void shutdownServer();
+            // setSocketPath
+            // path - file to also listen for clients on as a unix domain socket, must be set before start
+            void setSocketPath(std::string path);
+            // setAcceptThreads
+            // num_threads - threads accepting clients on the tcp port, each listening on its own socket with the kernel
+            //               spreading connections between them, must be set before start
+            void setAcceptThreads(std::size_t num_threads);
+            // backlog - connections the kernel queues on each listener before they are accepted, must be set before start
+            void setBacklog(int backlog);
+            // ms - time a client gets to finish the handshake before its connection is dropped
+            void setHandshakeTimeout(int ms);
+            // num_workers - threads handling the requests of every client, 0 for one per hardware thread, must be set before start
+            void setWorkers(std::size_t num_workers);
             void setMaxEls(int maxEls);
             int getMaxEls();
             int getNumElsInMemory();
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace UML {
+
+    // WorkerPool
+    // fixed number of threads running tasks. Each worker has its own queue, tasks submitted from a worker go
+    // on that worker's queue and tasks submitted from anywhere else are spread round robin. Workers run their
+    // own queue in order and steal from the back of the others once theirs is empty
+    class WorkerPool {
+        private:
+            struct Worker {
+                std::deque<std::function<void()>> tasks;
+                std::mutex mtx;
+                std::thread thread;
+            };
+            std::vector<std::unique_ptr<Worker>> m_workers;
+            std::size_t m_next_worker = 0; // guarded by m_idleMtx
+
+            // idle workers sleep on this until there is something queued anywhere
+            std::mutex m_idleMtx;
+            std::condition_variable m_idleCv;
+            std::size_t m_num_tasks = 0;
+            bool m_stopping = false;
+
+            void run(std::size_t worker_index);
+            bool take(std::size_t worker_index, std::function<void()>& task);
+        public:
+            WorkerPool() = default;
+            WorkerPool(const WorkerPool&) = delete;
+            WorkerPool& operator=(const WorkerPool&) = delete;
+            ~WorkerPool();
+
+            void start(std::size_t num_workers);
+            // runs what is still queued, then stops every worker, must not be called from one of the workers
+            void stop();
+            // tasks submitted from outside the pool after it stopped are dropped
+            void submit(std::function<void()> task);
+            std::size_t size() const { return m_workers.size(); }
+    };
+}
@@ -0,0 +1,31 @@
+#include "gtest/gtest.h"
+#include "uml-server/backlinkIndex.h"
+
+using namespace UML;
+using namespace EGM;
+
+class BacklinkIndexTest : public ::testing::Test {};
+
+TEST_F(BacklinkIndexTest, replaceReferences) {
+    BacklinkIndex index;
+    ID property_id = ID::randomID();
+    ID type_id = ID::randomID();
+    ID other_type_id = ID::randomID();
+    ID class_id = ID::randomID();
+
+    index.set_references(property_id, { {type_id, "type"}, {class_id, "class"} });
+    auto references = index.referenced_by(type_id);
+    ASSERT_EQ(references.size(), 1);
+    ASSERT_EQ(references.front().first, property_id);
+    ASSERT_EQ(references.front().second, "type");
+
+    // retyping the property moves the backlink
+    index.set_references(property_id, { {other_type_id, "type"}, {class_id, "class"} });
+    ASSERT_TRUE(index.referenced_by(type_id).empty());
+    ASSERT_EQ(index.referenced_by(other_type_id).size(), 1);
+    ASSERT_EQ(index.referenced_by(class_id).size(), 1);
+
+    index.unindex(property_id);
+    ASSERT_TRUE(index.referenced_by(other_type_id).empty());
+    ASSERT_TRUE(index.referenced_by(class_id).empty());
+}
@@ -0,0 +1,62 @@
+#include "gtest/gtest.h"
+#include "uml-server/elementTypeIndex.h"
+#include <algorithm>
+
+using namespace UML;
+using namespace EGM;
+
+class ElementTypeIndexTest : public ::testing::Test {};
+
+TEST_F(ElementTypeIndexTest, resumeAfterLastId) {
+    ElementTypeIndex index;
+    std::vector<ID> ids;
+    for (int i = 0; i < 5; i++) {
+        ids.push_back(ID::randomID());
+        index.index(ids.back(), {1});
+    }
+    index.index(ID::randomID(), {2});
+    ASSERT_EQ(index.count(1), 5);
+
+    // page through two at a time
+    std::vector<std::string> visited;
+    std::string after;
+    while (true) {
+        std::vector<std::string> page;
+        index.for_each(1, after, [&page](const std::string& id_string) {
+            page.push_back(id_string);
+            return page.size() < 2;
+        });
+        if (page.empty()) {
+            break;
+        }
+        visited.insert(visited.end(), page.begin(), page.end());
+        after = page.back();
+    }
+    ASSERT_EQ(visited.size(), 5);
+    ASSERT_TRUE(std::is_sorted(visited.begin(), visited.end()));
+
+    index.unindex(ids[0]);
+    index.index(ids[1], {2});
+    ASSERT_EQ(index.count(1), 3);
+    ASSERT_EQ(index.count(2), 2);
+}
+
+TEST_F(ElementTypeIndexTest, indexedUnderEveryType) {
+    // 1 and 2 stand in for a type and a type it inherits from
+    ElementTypeIndex index;
+    ID derived_id = ID::randomID();
+    ID base_id = ID::randomID();
+    index.index(derived_id, {1, 2});
+    index.index(base_id, {2});
+    ASSERT_EQ(index.count(1), 1);
+    ASSERT_EQ(index.count(2), 2);
+    ASSERT_TRUE(index.is(derived_id, 2));
+    ASSERT_FALSE(index.is(base_id, 1));
+
+    index.index(derived_id, {3, 2});
+    ASSERT_EQ(index.count(1), 0);
+    ASSERT_EQ(index.count(2), 2);
+    index.unindex(derived_id);
+    ASSERT_EQ(index.count(2), 1);
+    ASSERT_EQ(index.count(3), 0);
+}
@@ -191,3 +191,252 @@ TEST_F(GenerativeManagerTest, reloadStereotypedElement) {
     ASSERT_EQ(reloaded_stereotyped_uml_element.id(), stereotyped_uml_element.id());
     ASSERT_EQ(first_stereotype_inst->data.at(property.id())->getData(), "foo");
 }
+
+TEST_F(GenerativeManagerTest, streamAllDataInChunks) {
+    BasicGenerativeManager m;
+    auto stereotype = m.create<Stereotype>();
+    stereotype->setName("meta");
+    auto property = m.create<Property>();
+    property->setName("string_val");
+    stereotype->getOwnedAttributes().add(property);
+    property->setType(string_type_id);
+
+    ID meta_manager_id = m.generate(*stereotype);
+    auto& meta_manager = m.get_meta_manager(meta_manager_id);
+    std::unordered_set<ID> created_ids;
+    for (int i = 0; i < 10; i++) {
+        auto meta_element = meta_manager.create(stereotype.id());
+        meta_element->data.at(property.id())->setData(std::to_string(i));
+        created_ids.insert(meta_element.id());
+    }
+
+    std::unordered_set<ID> streamed_ids;
+    meta_manager.stream_all_data([&streamed_ids](std::string& meta_element_data) {
+        auto meta_element_node = YAML::Load(meta_element_data);
+        streamed_ids.insert(ID::fromString(meta_element_node["meta"]["id"].as<std::string>()));
+    }, 3);
+    ASSERT_EQ(streamed_ids, created_ids);
+}
+
+TEST_F(GenerativeManagerTest, renamedPropertyEmitTest) {
+    BasicGenerativeManager m;
+    auto stereotype = m.create<Stereotype>();
+    stereotype->setName("meta");
+    auto property = m.create<Property>();
+    property->setName("string_val");
+    stereotype->getOwnedAttributes().add(property);
+    property->setType(string_type_id);
+
+    ID meta_manager_id = m.generate(*stereotype);
+    auto& meta_manager = m.get_meta_manager(meta_manager_id);
+    auto meta_element = meta_manager.create(stereotype.id());
+    meta_element->data.at(property.id())->setData("val");
+    ASSERT_TRUE(YAML::Load(meta_manager.emit_meta_element(*meta_element))["meta"]["string_val"]);
+
+    property->setName("renamed_val");
+    meta_manager.rename_property(property.id(), property->getName());
+    auto meta_element_node = YAML::Load(meta_manager.emit_meta_element(*meta_element));
+    ASSERT_FALSE(meta_element_node["meta"]["string_val"]);
+    ASSERT_EQ(meta_element_node["meta"]["renamed_val"].as<std::string>(), "val");
+}
+
+TEST_F(GenerativeManagerTest, restoreReleasedMetaElement) {
+    BasicGenerativeManager m;
+    setup_foo_bar_profile(m);
+    ID meta_manager_id = m.generate(*profile);
+    auto& meta_manager = m.get_meta_manager(meta_manager_id);
+
+    auto stereotyped_element = m.create<Class>();
+    auto bar = meta_manager.apply(*stereotyped_element, stereotype.id());
+    auto foo = meta_manager.create(foo_type.id());
+    bar->getSet(foo_property.id()).add(foo);
+    ID bar_id = bar.id();
+    ID foo_id = foo.id();
+    meta_manager.release(*bar);
+    ASSERT_FALSE(meta_manager.loaded(bar_id));
+
+    MetaManager::Pointer<MetaElement> restored_bar = meta_manager.get(bar_id);
+    ASSERT_EQ(restored_bar->name, "Bar");
+    ASSERT_EQ(restored_bar->applying_element.id(), stereotyped_element.id());
+    ASSERT_EQ(restored_bar->getSet(foo_property.id()).size(), 1);
+    ASSERT_EQ(restored_bar->getSet(foo_property.id()).ids().front(), foo_id);
+}
+
+TEST_F(GenerativeManagerTest, restoreMetaElementWrittenToDisk) {
+    BasicGenerativeManager m;
+    auto stereotype = m.create<Stereotype>();
+    stereotype->setName("meta");
+    auto property = m.create<Property>();
+    property->setName("string_val");
+    stereotype->getOwnedAttributes().add(property);
+    property->setType(string_type_id);
+    ID meta_manager_id = m.generate(*stereotype);
+    auto& meta_manager = m.get_meta_manager(meta_manager_id);
+
+    // only the last one released stays serialized in memory, the others are written out and read back
+    meta_manager.set_record_limit(1);
+    std::vector<ID> meta_element_ids;
+    for (int i = 0; i < 5; i++) {
+        auto meta_element = meta_manager.create(stereotype.id());
+        meta_element->data.at(property.id())->setData(std::to_string(i));
+        meta_element_ids.push_back(meta_element.id());
+        meta_manager.release(*meta_element);
+    }
+    for (int i = 0; i < 5; i++) {
+        auto restored = meta_manager.get(meta_element_ids[i]);
+        ASSERT_EQ(restored->data.at(property.id())->getData(), std::to_string(i));
+    }
+}
+
+TEST_F(GenerativeManagerTest, discoverTypesInSteps) {
+    BasicGenerativeManager m;
+    setup_foo_bar_profile(m);
+    ID meta_manager_id = m.generate_deferred(*profile);
+    auto& meta_manager = m.get_meta_manager(meta_manager_id);
+    ASSERT_TRUE(meta_manager.discovering_types());
+    ASSERT_FALSE(meta_manager.discover_types(1));
+    while (!meta_manager.discover_types(1)) {}
+    ASSERT_FALSE(meta_manager.discovering_types());
+    std::size_t num_types = meta_manager.num_types();
+
+    // nothing changed, nothing to walk again
+    meta_manager.rediscover_types();
+    ASSERT_FALSE(meta_manager.discovering_types());
+
+    // extend the manager with a stereotype added after generation
+    auto baz = m.create<Stereotype>();
+    baz->setName("Baz");
+    profile->getPackagedElements().add(baz);
+    meta_manager.element_changed(baz.id(), profile.id());
+    meta_manager.rediscover_types();
+    ASSERT_TRUE(meta_manager.discovering_types());
+    ASSERT_TRUE(meta_manager.discover_types());
+    ASSERT_EQ(meta_manager.num_types(), num_types + 1);
+    auto baz_element = meta_manager.create(baz.id());
+    ASSERT_EQ(baz_element->name, "Baz");
+}
+
+TEST_F(GenerativeManagerTest, loadSavedTypeTable) {
+    BasicGenerativeManager m;
+    setup_foo_bar_profile(m);
+    ID meta_manager_id = m.generate(*profile);
+    auto& meta_manager = m.get_meta_manager(meta_manager_id);
+    YAML::Emitter emitter;
+    meta_manager.emit_type_table(emitter);
+    std::string saved_hash = meta_manager.profile_hash();
+
+    ID loaded_manager_id = m.generate_deferred(*profile);
+    auto& loaded_manager = m.get_meta_manager(loaded_manager_id);
+    ASSERT_TRUE(loaded_manager.load_type_table(YAML::Load(emitter.c_str()), saved_hash));
+    ASSERT_FALSE(loaded_manager.discovering_types());
+    ASSERT_EQ(loaded_manager.num_types(), meta_manager.num_types());
+    ASSERT_EQ(loaded_manager.get_type_with_id(stereotype.id()), meta_manager.get_type_with_id(stereotype.id()));
+    auto bar = loaded_manager.create(stereotype.id());
+    ASSERT_EQ(bar->name, "Bar");
+
+    // a table that is not the one hashed is not used
+    ID bad_manager_id = m.generate_deferred(*profile);
+    auto& bad_manager = m.get_meta_manager(bad_manager_id);
+    ASSERT_FALSE(bad_manager.load_type_table(YAML::Load(emitter.c_str()), "0"));
+    ASSERT_EQ(bad_manager.num_types(), 0);
+
+    // a classifier changed since saving is caught the first time its type is used
+    stereotype->setName("Baz");
+    ID stale_manager_id = m.generate_deferred(*profile);
+    auto& stale_manager = m.get_meta_manager(stale_manager_id);
+    ASSERT_TRUE(stale_manager.load_type_table(YAML::Load(emitter.c_str()), saved_hash));
+    ASSERT_FALSE(stale_manager.get_type_by_name("Bar"));
+    ASSERT_EQ(stale_manager.get_type_by_name("Baz"), meta_manager.get_type_with_id(stereotype.id()));
+    ASSERT_EQ(stale_manager.create(stereotype.id())->name, "Baz");
+}
+
+TEST_F(GenerativeManagerTest, profileHashSeesPropertyNamesAndLoadedTableFindsNewClassifiers) {
+    BasicGenerativeManager m;
+    setup_foo_bar_profile(m);
+    ID meta_manager_id = m.generate(*profile);
+    auto& meta_manager = m.get_meta_manager(meta_manager_id);
+    std::string saved_hash = meta_manager.profile_hash();
+    YAML::Emitter emitter;
+    meta_manager.emit_type_table(emitter);
+
+    // a renamed property changes the hash
+    foo_property->setName("renamed_foo");
+    ASSERT_NE(meta_manager.profile_hash(), saved_hash);
+    foo_property->setName("foo");
+    ASSERT_EQ(meta_manager.profile_hash(), saved_hash);
+
+    // a stereotype added to the profile after saving is not in the table, asking for it walks the profile
+    auto baz = m.create<Stereotype>();
+    baz->setName("Baz");
+    profile->getPackagedElements().add(baz);
+    ID loaded_manager_id = m.generate_deferred(*profile);
+    auto& loaded_manager = m.get_meta_manager(loaded_manager_id);
+    ASSERT_TRUE(loaded_manager.load_type_table(YAML::Load(emitter.c_str()), saved_hash));
+    std::size_t num_types = loaded_manager.num_types();
+    ASSERT_TRUE(loaded_manager.get_type_by_name("Baz"));
+    ASSERT_EQ(loaded_manager.num_types(), num_types + 1);
+}
+
+TEST_F(GenerativeManagerTest, releaseStereotypedElementThroughIndex) {
+    BasicGenerativeManager m;
+    setup_foo_bar_profile(m);
+    ID meta_manager_id = m.generate(*profile);
+    auto& meta_manager = m.get_meta_manager(meta_manager_id);
+
+    auto stereotyped_element = m.create<Class>();
+    auto bar = meta_manager.apply(*stereotyped_element, stereotype.id());
+    ID bar_id = bar.id();
+    ID stereotyped_element_id = stereotyped_element.id();
+    auto applied = m.applied_meta_elements(stereotyped_element_id);
+    ASSERT_EQ(applied.size(), 1);
+    ASSERT_EQ(applied.front().first, meta_manager_id);
+    ASSERT_EQ(applied.front().second, bar_id);
+
+    m.release(*stereotyped_element);
+    ASSERT_FALSE(meta_manager.loaded(bar_id));
+    ASSERT_EQ(m.applied_meta_elements(stereotyped_element_id).size(), 1);
+
+    MetaManager::Pointer<MetaElement> restored_bar = meta_manager.get(bar_id);
+    ASSERT_EQ(restored_bar->applying_element.id(), stereotyped_element_id);
+    meta_manager.erase(*restored_bar);
+    ASSERT_TRUE(m.applied_meta_elements(stereotyped_element_id).empty());
+}
+
+TEST_F(GenerativeManagerTest, releaseResidentMetaElementAndMirror) {
+    BasicGenerativeManager m;
+    setup_foo_bar_profile(m);
+    ID meta_manager_id = m.generate(*profile);
+    auto& meta_manager = m.get_meta_manager(meta_manager_id);
+
+    auto foo = meta_manager.create(foo_type.id());
+    ID foo_id = foo.id();
+    ASSERT_TRUE(m.loaded(foo_id));
+    meta_manager.release_resident(foo_id);
+    ASSERT_FALSE(meta_manager.loaded(foo_id));
+    ASSERT_FALSE(m.loaded(foo_id));
+
+    MetaManager::Pointer<MetaElement> restored_foo = meta_manager.get(foo_id);
+    ASSERT_EQ(restored_foo->name, "Foo");
+}
+
+TEST_F(GenerativeManagerTest, applyStereotypeToManyElements) {
+    BasicGenerativeManager m;
+    setup_foo_bar_profile(m);
+    ID meta_manager_id = m.generate(*profile);
+    auto& meta_manager = m.get_meta_manager(meta_manager_id);
+
+    std::vector<UmlManager::Pointer<Element>> applying_elements;
+    for (int i = 0; i < 10; i++) {
+        applying_elements.push_back(m.create<Class>());
+    }
+    auto applied = meta_manager.apply_all(applying_elements, *meta_manager.get_type_with_id(stereotype.id()));
+    ASSERT_EQ(applied.size(), applying_elements.size());
+    for (std::size_t i = 0; i < applied.size(); i++) {
+        ASSERT_EQ(applied[i]->name, "Bar");
+        ASSERT_EQ(applied[i]->applying_element.id(), applying_elements[i].id());
+        ASSERT_EQ(applying_elements[i]->getAppliedStereotypes().size(), 1);
+        ASSERT_EQ(applying_elements[i]->getAppliedStereotypes().ids().front(), applied[i].id());
+        // the attributes walked once for the batch are laid out in every element
+        ASSERT_TRUE(applied[i]->sets.contains(foo_property.id()));
+    }
+}
@@ -170,3 +170,26 @@ TEST_F(MetaManagerTest, different_set_types) {
     ASSERT_EQ(meta_element->sets.at(ordered_property.id())->setType(), SetType::ORDERED_SET);
     ASSERT_EQ(meta_element->sets.at(singleton_property.id())->setType(), SetType::SINGLETON);
 }
+
+TEST_F(MetaManagerTest, propertyNamesSharedByType) {
+    UmlManager m;
+    auto root = m.create<Package>();
+    auto clazz = m.create<Class>();
+    auto type = m.create<Class>();
+    auto property = m.create<Property>();
+    root->setName("root");
+    clazz->setName("test");
+    type->setName("type");
+    property->setName("prop");
+    root->getPackagedElements().add(clazz);
+    root->getPackagedElements().add(type);
+    property->setType(type);
+    clazz->getOwnedAttributes().add(property);
+
+    MetaManager mm(*root);
+    MetaElementPtr first = mm.create(clazz.id());
+    MetaElementPtr second = mm.create(clazz.id());
+    ASSERT_TRUE(first->property_names);
+    ASSERT_EQ(first->property_names, second->property_names);
+    ASSERT_EQ(first->property_names->at(property.id()), "prop");
+}
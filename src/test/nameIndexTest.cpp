@@ -0,0 +1,76 @@
+#include "gtest/gtest.h"
+#include "uml-server/nameIndex.h"
+
+using namespace UML;
+using namespace EGM;
+
+class NameIndexTest : public ::testing::Test {};
+
+TEST_F(NameIndexTest, rankedPrefixSearch) {
+    NameIndex index;
+    ID foo_id = ID::randomID();
+    ID lower_foo_id = ID::randomID();
+    ID foo_bar_id = ID::randomID();
+    ID my_foo_id = ID::randomID();
+    index.index(foo_bar_id, "FooBar");
+    index.index(my_foo_id, "myFooThing");
+    index.index(lower_foo_id, "foo");
+    index.index(foo_id, "Foo");
+
+    auto matches = index.search("Foo", NameIndex::SearchMode::PREFIX, false, 10);
+    ASSERT_EQ(matches.size(), 4);
+    ASSERT_EQ(matches[0], foo_id);
+    ASSERT_EQ(matches[1], lower_foo_id);
+    ASSERT_EQ(matches[2], foo_bar_id);
+    ASSERT_EQ(matches[3], my_foo_id);
+
+    // the best ranked are kept when the limit cuts the results short
+    auto limited_matches = index.search("Foo", NameIndex::SearchMode::PREFIX, false, 2);
+    ASSERT_EQ(limited_matches.size(), 2);
+    ASSERT_EQ(limited_matches[0], foo_id);
+    ASSERT_EQ(limited_matches[1], lower_foo_id);
+    auto best_match = index.search("Foo", NameIndex::SearchMode::PREFIX, false, 1);
+    ASSERT_EQ(best_match.size(), 1);
+    ASSERT_EQ(best_match.front(), foo_id);
+
+    auto exact_matches = index.search("Foo", NameIndex::SearchMode::EXACT, true, 10);
+    ASSERT_EQ(exact_matches.size(), 1);
+    ASSERT_EQ(exact_matches.front(), foo_id);
+
+    auto word_matches = index.search("thing", NameIndex::SearchMode::PREFIX, false, 10);
+    ASSERT_EQ(word_matches.size(), 1);
+    ASSERT_EQ(word_matches.front(), my_foo_id);
+}
+
+TEST_F(NameIndexTest, renameAndDelete) {
+    NameIndex index;
+    ID id = ID::randomID();
+    index.index(id, "before");
+    index.index(id, "after");
+    ASSERT_TRUE(index.search("before", NameIndex::SearchMode::EXACT, false, 10).empty());
+    ASSERT_EQ(index.search("after", NameIndex::SearchMode::EXACT, false, 10).size(), 1);
+    index.unindex(id);
+    ASSERT_TRUE(index.search("after", NameIndex::SearchMode::PREFIX, false, 10).empty());
+}
+
+TEST_F(NameIndexTest, sameRankInNameOrder) {
+    NameIndex index;
+    ID foo_c_id = ID::randomID();
+    ID foo_a_id = ID::randomID();
+    ID foo_b_id = ID::randomID();
+    ID word_id = ID::randomID();
+    index.index(word_id, "aFoo");
+    index.index(foo_c_id, "fooC");
+    index.index(foo_a_id, "fooA");
+    index.index(foo_b_id, "fooB");
+
+    auto matches = index.search("foo", NameIndex::SearchMode::PREFIX, false, 3);
+    ASSERT_EQ(matches.size(), 3);
+    ASSERT_EQ(matches[0], foo_a_id);
+    ASSERT_EQ(matches[1], foo_b_id);
+    ASSERT_EQ(matches[2], foo_c_id);
+
+    auto all_matches = index.search("foo", NameIndex::SearchMode::PREFIX, false, 10);
+    ASSERT_EQ(all_matches.size(), 4);
+    ASSERT_EQ(all_matches[3], word_id);
+}
@@ -0,0 +1,123 @@
+#include "gtest/gtest.h"
+#include "uml-server/qualifiedNameIndex.h"
+
+using namespace UML;
+using namespace EGM;
+
+class QualifiedNameIndexTest : public ::testing::Test {};
+
+TEST_F(QualifiedNameIndexTest, lookupByQualifiedName) {
+    QualifiedNameIndex index;
+    ID root_id = ID::randomID();
+    ID package_id = ID::randomID();
+    ID class_id = ID::randomID();
+
+    // children may be indexed before their owner
+    index.index(class_id, "Foo", package_id);
+    index.set_root(root_id, "root");
+    index.index(package_id, "pack", root_id);
+
+    ASSERT_EQ(*index.lookup(""), root_id);
+    ASSERT_EQ(*index.lookup("root"), root_id);
+    ASSERT_EQ(*index.lookup("root::pack"), package_id);
+    ASSERT_EQ(*index.lookup("root::pack::Foo"), class_id);
+    ASSERT_FALSE(index.lookup("root::pack::Bar"));
+    ASSERT_FALSE(index.lookup("other::pack"));
+    ASSERT_EQ(*index.qualified_name(class_id), "root::pack::Foo");
+
+    // every qualified name looks up the element it names, the root included
+    ASSERT_EQ(*index.qualified_name(root_id), "root");
+    for (auto& id : {root_id, package_id, class_id}) {
+        ASSERT_EQ(*index.lookup(*index.qualified_name(id)), id);
+    }
+}
+
+TEST_F(QualifiedNameIndexTest, renameMoveAndDelete) {
+    QualifiedNameIndex index;
+    ID root_id = ID::randomID();
+    ID package_id = ID::randomID();
+    ID class_id = ID::randomID();
+    index.set_root(root_id, "root");
+    index.index(package_id, "pack", root_id);
+    index.index(class_id, "Foo", package_id);
+
+    index.index(class_id, "Bar", package_id);
+    ASSERT_FALSE(index.lookup("root::pack::Foo"));
+    ASSERT_EQ(*index.lookup("root::pack::Bar"), class_id);
+
+    index.index(class_id, "Bar", root_id);
+    ASSERT_FALSE(index.lookup("root::pack::Bar"));
+    ASSERT_EQ(*index.lookup("root::Bar"), class_id);
+
+    index.index(package_id, "renamed", root_id);
+    index.index(class_id, "Bar", package_id);
+    ASSERT_EQ(*index.lookup("root::renamed::Bar"), class_id);
+
+    index.unindex(package_id);
+    ASSERT_FALSE(index.contains(package_id));
+    ASSERT_FALSE(index.contains(class_id));
+    ASSERT_FALSE(index.lookup("root::renamed"));
+}
+
+TEST_F(QualifiedNameIndexTest, lookupByPrefix) {
+    QualifiedNameIndex index;
+    ID root_id = ID::randomID();
+    index.set_root(root_id, "root");
+    ID foo_id = ID::randomID();
+    ID food_id = ID::randomID();
+    ID bar_id = ID::randomID();
+    index.index(foo_id, "foo", root_id);
+    index.index(food_id, "food", root_id);
+    index.index(bar_id, "bar", root_id);
+
+    auto matches = index.lookup_prefix("root::fo", 10);
+    ASSERT_EQ(matches.size(), 2);
+    ASSERT_EQ(matches[0], foo_id);
+    ASSERT_EQ(matches[1], food_id);
+    ASSERT_EQ(index.lookup_prefix("root::", 10).size(), 3);
+    ASSERT_EQ(index.lookup_prefix("root::", 1).size(), 1);
+    ASSERT_TRUE(index.lookup_prefix("root::baz", 10).empty());
+}
+
+TEST_F(QualifiedNameIndexTest, moveKeepsSubtree) {
+    QualifiedNameIndex index;
+    ID root_id = ID::randomID();
+    ID package_id = ID::randomID();
+    ID other_package_id = ID::randomID();
+    ID class_id = ID::randomID();
+    ID property_id = ID::randomID();
+    index.set_root(root_id, "root");
+    index.index(package_id, "pack", root_id);
+    index.index(other_package_id, "other", root_id);
+    index.index(class_id, "Foo", package_id);
+    index.index(property_id, "bar", class_id);
+
+    // only the moved element is indexed again, what it owns is found under its new owner
+    index.index(class_id, "Foo", other_package_id);
+    ASSERT_EQ(*index.owner_of(class_id), other_package_id);
+    ASSERT_FALSE(index.lookup("root::pack::Foo::bar"));
+    ASSERT_EQ(*index.lookup("root::other::Foo::bar"), property_id);
+    ASSERT_EQ(*index.qualified_name(property_id), "root::other::Foo::bar");
+    ASSERT_TRUE(index.owned_by(property_id, other_package_id));
+    ASSERT_FALSE(index.owned_by(property_id, package_id));
+}
+
+TEST_F(QualifiedNameIndexTest, visitOwnedElements) {
+    QualifiedNameIndex index;
+    ID root_id = ID::randomID();
+    ID package_id = ID::randomID();
+    ID class_id = ID::randomID();
+    ID other_id = ID::randomID();
+    index.set_root(root_id, "root");
+    index.index(package_id, "pack", root_id);
+    index.index(class_id, "Foo", package_id);
+    index.index(other_id, "other", root_id);
+
+    std::vector<ID> owned;
+    index.for_each_owned(package_id, [&owned](ID id) { owned.push_back(id); });
+    ASSERT_EQ(owned.size(), 1);
+    ASSERT_EQ(owned.front(), class_id);
+    owned.clear();
+    index.for_each_owned(root_id, [&owned](ID id) { owned.push_back(id); });
+    ASSERT_EQ(owned.size(), 3);
+}
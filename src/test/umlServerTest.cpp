@@ -5,6 +5,15 @@
 #include "test/umlSererTest.h"
 #include <stdlib.h>
 #include <thread>
+#include <filesystem>
+#include <chrono>
+#include <atomic>
+#include <format>
+#include <yaml-cpp/yaml.h>
+#include <sys/socket.h>
+#include <netdb.h>
+#include <unistd.h>
+#include <endian.h>
 
 using namespace UML;
 using namespace EGM;
@@ -357,3 +366,638 @@ UML_SERVER_SINGLETON_INTEGRATION_TEST(SlotOwningInstance, InstanceSpecification,
 
 // valueSpecification integration tests
 // UML_SERVER_SET_INTEGRATION_TEST(ExpressionOperands, Expression, Expression, Expreassion, getOperands)
+
+TEST_F(UmlServerTests, subtreeGetTest) {
+    UmlClient client;
+    auto root = client.create<Package>();
+    auto child = client.create<Package>();
+    auto grand_child = client.create<Class>();
+    root->getPackagedElements().add(*child);
+    child->getPackagedElements().add(*grand_child);
+    ID root_id = root.id();
+    ID child_id = child.id();
+    ID grand_child_id = grand_child.id();
+    client.release(*grand_child);
+    client.release(*child);
+    client.release(*root);
+
+    auto fetched_root = client.get(root_id, 1);
+    ASSERT_EQ(fetched_root.id(), root_id);
+    ASSERT_TRUE(client.loaded(child_id));
+    ASSERT_FALSE(client.loaded(grand_child_id));
+    ASSERT_EQ(fetched_root->as<Package>().getPackagedElements().size(), 1);
+}
+
+TEST_F(UmlServerTests, subtreeGetBadDepthTest) {
+    UmlClient client;
+    auto pckg = client.create<Package>();
+    ID pckg_id = pckg.id();
+    client.release(*pckg);
+
+    // a depth that is not a number is answered with an error rather than ending the request
+    ServerConnection connection("", UML_PORT);
+    for (std::string bad_depth : {"deep", "-1", "2x", ""}) {
+        auto reply = connection.request_async("{\"GET\":\"" + pckg_id.string() + "?depth=" + bad_depth + "\"}");
+        ASSERT_EQ(reply.wait_for(std::chrono::seconds(5)), std::future_status::ready);
+        ASSERT_NE(reply.get().find("invalid depth"), std::string::npos);
+    }
+    ASSERT_EQ(client.get(pckg_id, 0).id(), pckg_id);
+}
+
+TEST_F(UmlServerTests, querySubtypesUnderTest) {
+    UmlClient client;
+    auto pckg = client.create<Package>();
+    auto clazz = client.create<Class>();
+    auto nested_package = client.create<Package>();
+    pckg->getPackagedElements().add(*clazz);
+    pckg->getPackagedElements().add(*nested_package);
+    ID pckg_id = pckg.id();
+    ID clazz_id = clazz.id();
+    ID nested_package_id = nested_package.id();
+    client.release(*clazz);
+    client.release(*nested_package);
+    client.release(*pckg);
+
+    // elements of types inheriting from the type queried match as well
+    ServerConnection connection("", UML_PORT);
+    auto query = [&](std::string type) {
+        auto reply = connection.request_async(std::format("{{\"query\":{{\"type\":\"{}\",\"under\":\"{}\"}}}}", type, pckg_id.string()));
+        EXPECT_EQ(reply.wait_for(std::chrono::seconds(5)), std::future_status::ready);
+        return YAML::Load(reply.get());
+    };
+    auto classifiers = query("Classifier");
+    ASSERT_EQ(classifiers["ids"].size(), 1);
+    ASSERT_EQ(classifiers["ids"][0].as<std::string>(), clazz_id.string());
+    auto packageable_elements = query("PackageableElement");
+    ASSERT_EQ(packageable_elements["ids"].size(), 2);
+    ASSERT_TRUE(packageable_elements["next"].IsNull());
+    auto packages = query("Package");
+    ASSERT_EQ(packages["ids"].size(), 1);
+    ASSERT_EQ(packages["ids"][0].as<std::string>(), nested_package_id.string());
+}
+
+TEST_F(UmlServerTests, subscriptionNotificationTest) {
+    UmlClient client;
+    UmlClient subscriber;
+    auto pckg = client.create<Package>();
+    ID pckg_id = pckg.id();
+    subscriber.subscribe(pckg_id, SubscriptionScope::ELEMENT, true);
+
+    pckg->setName("renamed");
+    client.release(*pckg);
+
+    auto notification = subscriber.next_notification(1000);
+    ASSERT_TRUE(notification);
+    ASSERT_EQ(notification->kind, "put");
+    ASSERT_EQ(notification->id, pckg_id);
+    ASSERT_EQ(notification->type, "Package");
+    ASSERT_FALSE(notification->body.empty());
+
+    subscriber.unsubscribe(pckg_id);
+    auto pckg_again = client.get(pckg_id);
+    pckg_again->as<Package>().setName("again");
+    client.release(*pckg_again);
+    ASSERT_FALSE(subscriber.next_notification(100));
+}
+
+TEST_F(UmlServerTests, subscriberDisconnectsTest) {
+    UmlServer server(UML_PORT + 8, true);
+    server.start();
+    {
+        ServerConnection subscriber("", UML_PORT + 8);
+        auto subscribed = subscriber.request_async("{\"subscribe\":{\"type\":\"Package\"}}");
+        ASSERT_EQ(subscribed.wait_for(std::chrono::seconds(5)), std::future_status::ready);
+    }
+
+    // the client is dropped along with its subscriptions once its connection fails
+    for (int i = 0; i < 500 && server.numClients(); i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    ASSERT_EQ(server.numClients(), 0);
+
+    // so changes made afterwards are not sent to the closed socket and the server keeps going
+    ServerConnection writer("", UML_PORT + 8);
+    for (int i = 0; i < 2; i++) {
+        auto posted = writer.request_async("{\"POST\":{\"type\":\"Package\"}}");
+        ASSERT_EQ(posted.wait_for(std::chrono::seconds(5)), std::future_status::ready);
+        ASSERT_NE(posted.get().find("success"), std::string::npos);
+    }
+    ASSERT_EQ(server.numClients(), 1);
+    server.shutdownServer();
+}
+
+TEST_F(UmlServerTests, patchTest) {
+    UmlClient client;
+    auto pckg = client.create<Package>();
+    ID pckg_id = pckg.id();
+    for (int i = 0; i < 20; i++) {
+        auto child = client.create<Package>();
+        pckg->getPackagedElements().add(*child);
+        client.release(*child);
+    }
+    client.release(*pckg);
+
+    // the second save of a loaded element only sends what changed
+    auto pckg_again = client.get(pckg_id);
+    pckg_again->as<Package>().setName("patched");
+    auto new_child = client.create<Class>();
+    pckg_again->as<Package>().getPackagedElements().add(*new_child);
+    ID new_child_id = new_child.id();
+    client.release(*new_child);
+    client.release(*pckg_again);
+
+    UmlClient reader;
+    auto read_pckg = reader.get(pckg_id);
+    ASSERT_EQ(read_pckg->as<Package>().getName(), "patched");
+    ASSERT_EQ(read_pckg->as<Package>().getPackagedElements().size(), 21);
+    ASSERT_TRUE(read_pckg->as<Package>().getPackagedElements().contains(new_child_id));
+}
+
+TEST_F(UmlServerTests, patchErrorReplyTest) {
+    // whatever the error says, it comes back escaped so the reply parses
+    ServerConnection connection("", UML_PORT);
+    auto reply = connection.request_async("{\"PATCH\":{\"id\":\"" + ID::randomID().string() + "\",\"set\":{\"name\":\"a \\\"quoted\\\" name\"}}}");
+    ASSERT_EQ(reply.wait_for(std::chrono::seconds(5)), std::future_status::ready);
+    YAML::Node reply_node = YAML::Load(reply.get());
+    ASSERT_TRUE(reply_node["error"]);
+    ASSERT_NE(reply_node["error"].as<std::string>().find("Error handling patch request"), std::string::npos);
+}
+
+TEST_F(UmlServerTests, patchReorderTest) {
+    UmlClient client;
+    auto clazz = client.create<Class>();
+    ID clazz_id = clazz.id();
+    std::vector<ID> property_ids;
+    for (int i = 0; i < 20; i++) {
+        auto property = client.create<Property>();
+        clazz->getOwnedAttributes().add(*property);
+        property_ids.push_back(property.id());
+        client.release(*property);
+    }
+    client.release(*clazz);
+
+    // moving the first attribute to the end keeps the same ids but must still reach the server
+    auto clazz_again = client.get(clazz_id);
+    auto first_property = client.get(property_ids.front());
+    clazz_again->as<Class>().getOwnedAttributes().remove(first_property->as<Property>());
+    clazz_again->as<Class>().getOwnedAttributes().add(first_property->as<Property>());
+    client.release(*first_property);
+    client.release(*clazz_again);
+
+    UmlClient reader;
+    auto read_clazz = reader.get(clazz_id);
+    ASSERT_EQ(read_clazz->as<Class>().getOwnedAttributes().size(), 20);
+    ASSERT_EQ(read_clazz->as<Class>().getOwnedAttributes().front().id(), property_ids[1]);
+}
+
+TEST_F(UmlServerTests, clientCacheTest) {
+    UmlClient writer;
+    UmlClient reader;
+    reader.set_cache_size(100);
+    auto pckg = writer.create<Package>();
+    pckg->setName("cached");
+    ID pckg_id = pckg.id();
+    writer.release(*pckg);
+
+    auto read_pckg = reader.get(pckg_id);
+    ASSERT_EQ(read_pckg->as<Package>().getName(), "cached");
+    reader.release(*read_pckg);
+    ASSERT_TRUE(reader.cached(pckg_id));
+    auto cached_pckg = reader.get(pckg_id);
+    ASSERT_FALSE(reader.cached(pckg_id));
+    ASSERT_EQ(cached_pckg->as<Package>().getName(), "cached");
+    reader.release(*cached_pckg);
+
+    auto written_pckg = writer.get(pckg_id);
+    written_pckg->as<Package>().setName("changed");
+    writer.release(*written_pckg);
+
+    // the invalidation is pushed by the server so give it a moment to come in
+    for (int i = 0; i < 100 && reader.cached(pckg_id); i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    ASSERT_FALSE(reader.cached(pckg_id));
+    ASSERT_EQ(reader.get(pckg_id)->as<Package>().getName(), "changed");
+}
+
+TEST_F(UmlServerTests, clientCacheEvictionTest) {
+    UmlClient writer;
+    UmlClient reader;
+    reader.set_cache_size(1);
+    std::vector<ID> ids;
+    for (int i = 0; i < 2 * UML_CLIENT_UNCACHE_BATCH; i++) {
+        auto pckg = writer.create<Package>();
+        pckg->setName("evicted");
+        ids.push_back(pckg.id());
+        writer.release(*pckg);
+    }
+
+    // evicting tells the server in batches, it keeps invalidating only what is still cached
+    for (auto& id : ids) {
+        reader.release(*reader.get(id));
+    }
+    ASSERT_FALSE(reader.cached(ids.front()));
+    ASSERT_TRUE(reader.cached(ids.back()));
+
+    for (ID id : {ids.front(), ids.back()}) {
+        auto written_pckg = writer.get(id);
+        written_pckg->as<Package>().setName("changed");
+        writer.release(*written_pckg);
+    }
+    for (int i = 0; i < 100 && reader.cached(ids.back()); i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    ASSERT_FALSE(reader.cached(ids.back()));
+    ASSERT_EQ(reader.get(ids.front())->as<Package>().getName(), "changed");
+    ASSERT_EQ(reader.get(ids.back())->as<Package>().getName(), "changed");
+}
+
+TEST_F(UmlServerTests, diskCacheTest) {
+    std::string cache_path = (std::filesystem::temp_directory_path() / ("uml-client-cache-" + ID::randomID().string())).string();
+    ID kept_id;
+    ID stale_id;
+    {
+        UmlClient client;
+        client.open_disk_cache(cache_path);
+        auto kept = client.create<Package>();
+        kept->setName("kept");
+        kept_id = kept.id();
+        auto stale = client.create<Package>();
+        stale->setName("before");
+        stale_id = stale.id();
+        client.release(*kept);
+        client.release(*stale);
+    }
+    {
+        UmlClient writer;
+        auto stale = writer.get(stale_id);
+        stale->as<Package>().setName("after");
+        writer.release(*stale);
+    }
+
+    UmlClient client;
+    client.open_disk_cache(cache_path);
+    ASSERT_TRUE(client.cached(kept_id));
+    ASSERT_FALSE(client.cached(stale_id));
+    ASSERT_EQ(client.get(kept_id)->as<Package>().getName(), "kept");
+    ASSERT_EQ(client.get(stale_id)->as<Package>().getName(), "after");
+    std::filesystem::remove_all(cache_path);
+}
+
+TEST_F(UmlServerTests, asyncTest) {
+    const std::size_t num_packages = 50;
+    std::vector<ID> ids;
+    {
+        UmlClient writer;
+        std::vector<std::future<UmlClient::Pointer<Package>>> created;
+        for (std::size_t i = 0; i < num_packages; i++) {
+            created.push_back(writer.create_async<Package>());
+        }
+        std::vector<std::future<void>> released;
+        for (std::size_t i = 0; i < num_packages; i++) {
+            auto pckg = created[i].get();
+            pckg->setName("async" + std::to_string(i));
+            ids.push_back(pckg.id());
+            released.push_back(writer.release_async(*pckg));
+        }
+        for (auto& release : released) {
+            release.get();
+        }
+    }
+
+    // every get is sent before any reply is waited on
+    UmlClient reader;
+    std::vector<std::future<UmlClient::Pointer<Element>>> gotten;
+    for (auto& id : ids) {
+        gotten.push_back(reader.get_async(id));
+    }
+    for (std::size_t i = 0; i < num_packages; i++) {
+        auto el = gotten[i].get();
+        ASSERT_EQ(el.id(), ids[i]);
+        ASSERT_EQ(el->as<Package>().getName(), "async" + std::to_string(i));
+    }
+}
+
+#ifdef UML_SERVER_IO_URING
+TEST_F(UmlServerTests, ioUringBatchedSendsTest) {
+    // replies that fit a registered send buffer and replies that don't go out over the same socket in order
+    std::string big_name(2 * UML_SERVER_IO_URING_BUFFER_SIZE, 'b');
+    ID big_id = ID::nullID();
+    ID small_id = ID::nullID();
+    {
+        UmlClient writer;
+        auto big_pckg = writer.create<Package>();
+        big_pckg->setName(big_name);
+        big_id = big_pckg.id();
+        auto small_pckg = writer.create<Package>();
+        small_pckg->setName("small");
+        small_id = small_pckg.id();
+        writer.release(*big_pckg);
+        writer.release(*small_pckg);
+    }
+
+    ServerConnection connection("", UML_PORT);
+    std::vector<std::future<std::string>> replies;
+    for (std::size_t i = 0; i < 64; i++) {
+        ID id = i % 2 ? small_id : big_id;
+        replies.push_back(connection.request_async("{\"GET\":\"" + id.string() + "\"}"));
+    }
+    for (std::size_t i = 0; i < replies.size(); i++) {
+        ASSERT_EQ(replies[i].wait_for(std::chrono::seconds(5)), std::future_status::ready);
+        std::string reply = replies[i].get();
+        if (i % 2) {
+            ASSERT_NE(reply.find(small_id.string()), std::string::npos);
+            ASSERT_NE(reply.find("small"), std::string::npos);
+        } else {
+            ASSERT_NE(reply.find(big_id.string()), std::string::npos);
+            ASSERT_NE(reply.find(big_name), std::string::npos);
+        }
+    }
+}
+#endif
+
+TEST_F(UmlServerTests, unknownQualifiedNameReplyTest) {
+    // the name asked for is echoed back escaped so the reply still parses
+    ServerConnection connection("", UML_PORT);
+    auto reply = connection.request_async("{\"GET\":\"no\\\"such\"}");
+    ASSERT_EQ(reply.wait_for(std::chrono::seconds(5)), std::future_status::ready);
+    YAML::Node reply_node = YAML::Load(reply.get());
+    ASSERT_TRUE(reply_node["error"]);
+    ASSERT_NE(reply_node["error"].as<std::string>().find("no\"such"), std::string::npos);
+}
+
+TEST_F(UmlServerTests, receiveMessageTest) {
+    int sockets[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, sockets), 0);
+    std::string message = "split";
+    uint64_t message_size = htobe64(message.size());
+    const char* size_bytes = reinterpret_cast<const char*>(&message_size);
+
+    // a size that comes in pieces is put back together
+    std::thread writer([&]() {
+        send(sockets[1], size_bytes, 3, 0);
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        send(sockets[1], size_bytes + 3, sizeof(uint64_t) - 3, 0);
+        send(sockets[1], message.data(), message.size(), 0);
+    });
+    ASSERT_EQ(receive_message(sockets[0]), message);
+    writer.join();
+
+    // the peer closing part way through a frame ends the read instead of spinning
+    send(sockets[1], size_bytes, sizeof(uint64_t), 0);
+    send(sockets[1], message.data(), 2, 0);
+    close(sockets[1]);
+    ASSERT_FALSE(receive_message(sockets[0]));
+    close(sockets[0]);
+}
+
+TEST_F(UmlServerTests, malformedRequestReplyTest) {
+    // replies to requests that do not parse still carry the request's rid so the caller is not left waiting
+    ServerConnection connection("", UML_PORT);
+    auto reply = connection.request_async("{[}");
+    ASSERT_EQ(reply.wait_for(std::chrono::seconds(5)), std::future_status::ready);
+    ASSERT_NE(reply.get().find("error"), std::string::npos);
+}
+
+TEST_F(UmlServerTests, sharedConnectionTest) {
+    ServerConnection::share_connections(1);
+    {
+        UmlClient writer;
+        UmlClient subscriber;
+        auto pckg = writer.create<Package>();
+        ID pckg_id = pckg.id();
+        subscriber.subscribe(pckg_id);
+        pckg->setName("shared");
+        writer.release(*pckg);
+
+        // notifications go to the client on the connection that subscribed, not the one making the change
+        auto notification = subscriber.next_notification(1000);
+        ASSERT_TRUE(notification);
+        ASSERT_EQ(notification->id, pckg_id);
+        ASSERT_FALSE(writer.next_notification(100));
+        ASSERT_EQ(subscriber.get(pckg_id)->as<Package>().getName(), "shared");
+    }
+    ServerConnection::share_connections(0);
+}
+
+TEST_F(UmlServerTests, sharedConnectionPerServerTest) {
+    UmlServer other_server(UML_PORT + 7);
+    ServerConnection::share_connections(1);
+    {
+        // clients of different servers never end up on the same connection
+        auto connection = ServerConnection::shared("", UML_PORT);
+        ASSERT_EQ(ServerConnection::shared("", UML_PORT), connection);
+        auto other_connection = ServerConnection::shared("", UML_PORT + 7);
+        ASSERT_NE(other_connection, connection);
+        ASSERT_EQ(ServerConnection::shared("", UML_PORT + 7), other_connection);
+    }
+    ServerConnection::share_connections(0);
+    other_server.shutdownServer();
+}
+
+TEST_F(UmlServerTests, unixSocketTest) {
+    std::string socket_path = (std::filesystem::temp_directory_path() / "uml-server-unix-socket-test.sock").string();
+    UmlServer server(UML_PORT + 1, true);
+    server.setSocketPath(socket_path);
+    server.start();
+
+    // same round trips over tcp loopback to the test server and over the unix socket, recorded so the two
+    // transports can be compared
+    auto round_trips = [](std::string address) {
+        ServerConnection::set_default_address(address);
+        UmlClient client;
+        auto pckg = client.create<Package>();
+        ID pckg_id = pckg.id();
+        pckg->setName("unix");
+        client.release(*pckg);
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < 100; i++) {
+            auto& fetched = client.get(pckg_id)->as<Package>();
+            EXPECT_EQ(fetched.getName(), "unix");
+            client.release(fetched);
+        }
+        return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+    };
+    auto tcp_us = round_trips("");
+    auto unix_us = round_trips(std::string(ServerConnection::UNIX_ADDRESS_PREFIX) + socket_path);
+    ServerConnection::set_default_address("");
+    RecordProperty("tcp_loopback_round_trips_us", std::to_string(tcp_us));
+    RecordProperty("unix_socket_round_trips_us", std::to_string(unix_us));
+    server.shutdownServer();
+    ASSERT_FALSE(std::filesystem::exists(socket_path));
+}
+
+TEST_F(UmlServerTests, sharedMemoryTest) {
+    std::string socket_path = (std::filesystem::temp_directory_path() / "uml-server-shared-memory-test.sock").string();
+    UmlServer server(UML_PORT + 2, true);
+    server.setSocketPath(socket_path);
+    server.start();
+    ServerConnection::set_default_address(std::string(ServerConnection::UNIX_ADDRESS_PREFIX) + socket_path);
+    {
+        // reply is big enough to come through shared memory
+        std::string big_name(2 * UML_SERVER_SHARED_MEMORY_MIN, 'a');
+        UmlClient writer;
+        auto pckg = writer.create<Package>();
+        ID pckg_id = pckg.id();
+        pckg->setName(big_name);
+        writer.release(*pckg);
+
+        UmlClient reader;
+        ASSERT_EQ(reader.get(pckg_id)->as<Package>().getName(), big_name);
+    }
+    ServerConnection::set_default_address("");
+    ServerConnection connection(std::string(ServerConnection::UNIX_ADDRESS_PREFIX) + socket_path, 0);
+    #ifdef __linux__
+    ASSERT_TRUE(connection.shared_memory());
+    #endif
+    server.shutdownServer();
+}
+
+TEST_F(UmlServerTests, sharedMemoryMixedRepliesTest) {
+    std::string socket_path = (std::filesystem::temp_directory_path() / "uml-server-shared-memory-mixed-test.sock").string();
+    UmlServer server(UML_PORT + 9, true);
+    server.setSocketPath(socket_path);
+    server.start();
+    ServerConnection::set_default_address(std::string(ServerConnection::UNIX_ADDRESS_PREFIX) + socket_path);
+    {
+        std::string big_name(2 * UML_SERVER_SHARED_MEMORY_MIN, 'b');
+        UmlClient writer;
+        std::vector<ID> ids;
+        for (int i = 0; i < 8; i++) {
+            auto pckg = writer.create<Package>();
+            ids.push_back(pckg.id());
+            pckg->setName(i % 2 ? big_name : std::to_string(i));
+            writer.release(*pckg);
+        }
+
+        // small and big replies to one connection back to back have to come out whole and in order
+        UmlClient reader;
+        for (int round = 0; round < 4; round++) {
+            for (int i = 0; i < 8; i++) {
+                auto pckg = reader.get(ids[i]);
+                ASSERT_EQ(pckg->as<Package>().getName(), i % 2 ? big_name : std::to_string(i));
+                reader.release(*pckg);
+            }
+        }
+    }
+    ServerConnection::set_default_address("");
+    server.shutdownServer();
+}
+
+TEST_F(UmlServerTests, acceptThreadsTest) {
+    UmlServer server(UML_PORT + 3, true);
+    server.setAcceptThreads(4);
+    server.setBacklog(128);
+    server.start();
+    {
+        // connect all at once so the kernel spreads them over the listeners
+        std::vector<std::unique_ptr<ServerConnection>> connections(32);
+        std::vector<std::thread> connecting;
+        for (auto& connection : connections) {
+            connecting.emplace_back([&connection]() {
+                connection = std::make_unique<ServerConnection>("", UML_PORT + 3);
+            });
+        }
+        for (auto& connecting_thread : connecting) {
+            connecting_thread.join();
+        }
+        for (auto& connection : connections) {
+            ASSERT_TRUE(connection);
+        }
+        ASSERT_EQ(server.numClients(), 32);
+    }
+    server.shutdownServer();
+}
+
+TEST_F(UmlServerTests, slowHandshakeTest) {
+    UmlServer server(UML_PORT + 4, true);
+    server.setHandshakeTimeout(200);
+    server.start();
+
+    // connect without ever sending an id
+    struct addrinfo hints;
+    struct addrinfo* address;
+    memset(&hints, 0, sizeof hints);
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    ASSERT_EQ(getaddrinfo(0, std::to_string(UML_PORT + 4).c_str(), &hints, &address), 0);
+    int stalled_socket = socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+    ASSERT_NE(connect(stalled_socket, address->ai_addr, address->ai_addrlen), -1);
+    freeaddrinfo(address);
+
+    // other clients get through while it stalls
+    {
+        ServerConnection connection("", UML_PORT + 4);
+        ASSERT_EQ(server.numClients(), 1);
+    }
+
+    // and it is dropped once the timeout passes, after getting the meta managers
+    ASSERT_TRUE(receive_message(stalled_socket));
+    char buffer;
+    ASSERT_EQ(recv(stalled_socket, &buffer, 1, 0), 0);
+    close(stalled_socket);
+    server.shutdownServer();
+}
+
+TEST_F(UmlServerTests, workerPoolTest) {
+    UmlServer server(UML_PORT + 5, true);
+    server.setWorkers(4);
+    server.start();
+    {
+        // pipelined requests from many clients at once all get their replies
+        std::vector<std::thread> clients;
+        std::atomic<int> num_failures = 0;
+        for (int i = 0; i < 8; i++) {
+            clients.emplace_back([&num_failures]() {
+                auto connection = std::make_shared<ServerConnection>("", UML_PORT + 5);
+                std::vector<std::future<std::string>> replies;
+                for (int j = 0; j < 50; j++) {
+                    replies.push_back(connection->request_async("{\"lookup\":{\"prefix\":\"\",\"limit\":1}}"));
+                }
+                for (auto& reply : replies) {
+                    if (reply.get().find("matches") == std::string::npos) {
+                        num_failures++;
+                    }
+                }
+            });
+        }
+        for (auto& client : clients) {
+            client.join();
+        }
+        ASSERT_EQ(num_failures, 0);
+    }
+    server.shutdownServer();
+}
+
+TEST_F(UmlServerTests, killWithOneWorkerTest) {
+    UmlServer server(UML_PORT + 6, true);
+    server.setWorkers(1);
+    server.start();
+    ServerConnection other_client("", UML_PORT + 6);
+
+    // KILL is a raw message, it can't go through a ServerConnection which tags every request
+    struct addrinfo hints;
+    struct addrinfo* address;
+    memset(&hints, 0, sizeof hints);
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    ASSERT_EQ(getaddrinfo(0, std::to_string(UML_PORT + 6).c_str(), &hints, &address), 0);
+    int kill_socket = socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+    ASSERT_NE(connect(kill_socket, address->ai_addr, address->ai_addrlen), -1);
+    freeaddrinfo(address);
+    ASSERT_TRUE(receive_message(kill_socket));
+    std::string kill_id = ID::randomID().string();
+    send_message(kill_socket, kill_id);
+    ASSERT_EQ(receive_message(kill_socket), kill_id);
+    std::string kill_message = "KILL";
+    send_message(kill_socket, kill_message);
+    auto kill_reply = receive_message(kill_socket);
+    ASSERT_TRUE(kill_reply);
+    ASSERT_NE(kill_reply->find("shutdown"), std::string::npos);
+
+    // the only worker handled the KILL, shutting down must not wait on it
+    auto start = std::chrono::steady_clock::now();
+    server.waitTillShutDown(5000);
+    ASSERT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(5));
+    close(kill_socket);
+}
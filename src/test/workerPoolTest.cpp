@@ -0,0 +1,51 @@
+#include "gtest/gtest.h"
+#include "uml-server/workerPool.h"
+#include <atomic>
+#include <chrono>
+
+using namespace UML;
+
+class WorkerPoolTest : public ::testing::Test {};
+
+TEST_F(WorkerPoolTest, runsEverythingSubmittedBeforeStopping) {
+    std::atomic<int> num_run = 0;
+    WorkerPool pool;
+    pool.start(4);
+    ASSERT_EQ(pool.size(), 4);
+    for (int i = 0; i < 1000; i++) {
+        pool.submit([&num_run]() { num_run++; });
+    }
+
+    // tasks queued by running tasks while stopping still run
+    pool.submit([&pool, &num_run]() {
+        for (int i = 0; i < 100; i++) {
+            pool.submit([&num_run]() { num_run++; });
+        }
+    });
+    pool.stop();
+    ASSERT_EQ(num_run, 1100);
+
+    pool.submit([&num_run]() { num_run++; });
+    ASSERT_EQ(num_run, 1100);
+}
+
+TEST_F(WorkerPoolTest, idleWorkersStealTest) {
+    // every task lands on the queue of the worker submitting it, the others only get to them by stealing
+    WorkerPool pool;
+    pool.start(4);
+    std::atomic<int> num_running = 0;
+    std::atomic<int> most_running = 0;
+    pool.submit([&]() {
+        for (int i = 0; i < 8; i++) {
+            pool.submit([&]() {
+                int running = ++num_running;
+                int most = most_running;
+                while (running > most && !most_running.compare_exchange_weak(most, running)) {}
+                std::this_thread::sleep_for(std::chrono::milliseconds(50));
+                num_running--;
+            });
+        }
+    });
+    pool.stop();
+    ASSERT_GT(most_running, 1);
+}
@@ -0,0 +1,79 @@
+#include "uml-server/backlinkIndex.h"
+#include <algorithm>
+
+using namespace EGM;
+
+namespace UML {
+
+std::size_t BacklinkIndex::set_name_index(const std::string& set_name) {
+    auto match = m_set_name_indices.find(set_name);
+    if (match != m_set_name_indices.end()) {
+        return match->second;
+    }
+    m_set_names.push_back(set_name);
+    m_set_name_indices.emplace(set_name, m_set_names.size() - 1);
+    return m_set_names.size() - 1;
+}
+
+void BacklinkIndex::remove_references(ID source) {
+    auto references_match = m_references.find(source);
+    if (references_match == m_references.end()) {
+        return;
+    }
+    for (auto& reference : references_match->second) {
+        auto backlinks_match = m_backlinks.find(reference.first);
+        if (backlinks_match == m_backlinks.end()) {
+            continue;
+        }
+        std::erase_if(backlinks_match->second, [&source](IndexedReference& backlink) {
+            return backlink.first == source;
+        });
+        if (backlinks_match->second.empty()) {
+            m_backlinks.erase(backlinks_match);
+        }
+    }
+    m_references.erase(references_match);
+}
+
+void BacklinkIndex::set_references(ID source, const std::vector<Reference>& references) {
+    remove_references(source);
+    if (references.empty()) {
+        return;
+    }
+    auto& indexed_references = m_references[source];
+    indexed_references.reserve(references.size());
+    for (auto& reference : references) {
+        std::size_t set_index = set_name_index(reference.second);
+        indexed_references.emplace_back(reference.first, set_index);
+        auto& backlinks = m_backlinks[reference.first];
+        IndexedReference backlink(source, set_index);
+        if (std::find(backlinks.begin(), backlinks.end(), backlink) == backlinks.end()) {
+            backlinks.push_back(backlink);
+        }
+    }
+}
+
+void BacklinkIndex::unindex(ID id) {
+    remove_references(id);
+    m_backlinks.erase(id);
+}
+
+void BacklinkIndex::clear() {
+    m_references.clear();
+    m_backlinks.clear();
+}
+
+std::vector<BacklinkIndex::Reference> BacklinkIndex::referenced_by(ID target) const {
+    std::vector<Reference> ret;
+    auto backlinks_match = m_backlinks.find(target);
+    if (backlinks_match == m_backlinks.end()) {
+        return ret;
+    }
+    ret.reserve(backlinks_match->second.size());
+    for (auto& backlink : backlinks_match->second) {
+        ret.emplace_back(backlink.first, m_set_names[backlink.second]);
+    }
+    return ret;
+}
+
+}
@@ -0,0 +1,76 @@
+#include "uml-server/elementTypeIndex.h"
+#include <algorithm>
+
+using namespace EGM;
+
+namespace UML {
+
+void ElementTypeIndex::index(ID id, std::vector<std::size_t> element_types) {
+    auto type_match = m_types.find(id);
+    if (type_match != m_types.end()) {
+        if (type_match->second == element_types) {
+            return;
+        }
+        unindex(id);
+    }
+    std::string id_string = id.string();
+    for (auto element_type : element_types) {
+        m_ids_by_type[element_type].insert(id_string);
+    }
+    m_types.emplace(id, std::move(element_types));
+}
+
+void ElementTypeIndex::unindex(ID id) {
+    auto type_match = m_types.find(id);
+    if (type_match == m_types.end()) {
+        return;
+    }
+    std::string id_string = id.string();
+    for (auto element_type : type_match->second) {
+        auto ids_match = m_ids_by_type.find(element_type);
+        if (ids_match != m_ids_by_type.end()) {
+            ids_match->second.erase(id_string);
+            if (ids_match->second.empty()) {
+                m_ids_by_type.erase(ids_match);
+            }
+        }
+    }
+    m_types.erase(type_match);
+}
+
+void ElementTypeIndex::clear() {
+    m_ids_by_type.clear();
+    m_types.clear();
+}
+
+std::size_t ElementTypeIndex::count(std::size_t element_type) const {
+    auto ids_match = m_ids_by_type.find(element_type);
+    if (ids_match == m_ids_by_type.end()) {
+        return 0;
+    }
+    return ids_match->second.size();
+}
+
+bool ElementTypeIndex::is(ID id, std::size_t element_type) const {
+    auto type_match = m_types.find(id);
+    if (type_match == m_types.end()) {
+        return false;
+    }
+    return std::find(type_match->second.begin(), type_match->second.end(), element_type) != type_match->second.end();
+}
+
+void ElementTypeIndex::for_each(std::size_t element_type, std::string_view after, std::function<bool(const std::string&)> f) const {
+    auto ids_match = m_ids_by_type.find(element_type);
+    if (ids_match == m_ids_by_type.end()) {
+        return;
+    }
+    auto& ids = ids_match->second;
+    auto it = after.empty() ? ids.begin() : ids.upper_bound(after);
+    for (; it != ids.end(); it++) {
+        if (!f(*it)) {
+            return;
+        }
+    }
+}
+
+}
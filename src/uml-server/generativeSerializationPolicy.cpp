@@ -38,6 +38,8 @@ vector<ManagedPtr<AbstractElement>> GenerativeSerializationPolicy::parseWhole(st
      *          {
      *              uml_root: "id_of_root_that_generated_this"
      *              id: "id_of_meta_manager"
+     *              profile_hash: "hash_of_profile_when_saved"
+     *              types: [ MetaManager::emit_type_table ]
      *              data: [ MetaManager::dump_all_data ]
      *          },
      *          ...
@@ -72,8 +74,24 @@ vector<ManagedPtr<AbstractElement>> GenerativeSerializationPolicy::parseWhole(st
         for (auto meta_manager_node : meta_managers_nodes) {
             ID uml_generation_root_id = process_id_node(meta_manager_node["uml_root"]);
             ID meta_manager_id = process_id_node(meta_manager_node["id"]);
-            MetaManager& meta_manager = m_generative_manager->m_meta_managers.emplace(meta_manager_id, ManagedPtr<BaseElement>(m_generative_manager->abstractGet(uml_generation_root_id))->as<Package>()).first->second;
+            MetaManager& meta_manager = m_generative_manager->m_meta_managers.emplace(
+                    std::piecewise_construct,
+                    std::forward_as_tuple(meta_manager_id),
+                    std::forward_as_tuple(ManagedPtr<BaseElement>(m_generative_manager->abstractGet(uml_generation_root_id))->as<Package>(), true)
+                ).first->second;
             meta_manager.m_storage_root->setID(meta_manager_id);
+            meta_manager.set_record_limit(m_generative_manager->m_meta_record_limit);
+
+            // use the compiled type table if it was saved and the profile has not changed since
+            auto types_node = meta_manager_node["types"];
+            auto profile_hash_node = meta_manager_node["profile_hash"];
+            if (
+                !types_node || 
+                !profile_hash_node || 
+                !meta_manager.load_type_table(types_node, profile_hash_node.as<string>())
+            ) {
+                meta_manager.discover_types();
+            }
             
             auto data_node = meta_manager_node["data"];
             string data_node_line = to_string(data_node.Mark().line);
@@ -99,21 +117,26 @@ string GenerativeSerializationPolicy::emitWhole(AbstractElement& el) {
     emitter << YAML::BeginMap;
     emitter << YAML::Key << "uml" << YAML::Value;
     m_serializationByType.at(el.getElementType())->emitComposite(emitter, AbstractElementPtr(&el));
-    emitter << YAML::Key << "meta_managers" << YAML::Value;
-    emitter << YAML::BeginSeq;
-    for (auto& meta_manager_pair : m_generative_manager->m_meta_managers) {
-        emitter << YAML::BeginMap;
-        ID manager_id = meta_manager_pair.first;
-        MetaManager& meta_manager = meta_manager_pair.second;
-        emitter << YAML::Key << "uml_root" << YAML::Value << meta_manager.get_generation_root().id().string();
-        emitter << YAML::Key << "id" << YAML::Value << manager_id.string();
-        emitter << YAML::Key << "data";
-        meta_manager.dump_all_data(emitter);
-        emitter << YAML::EndMap;
+    if (!m_generative_manager->m_meta_managers.empty()) {
+        emitter << YAML::Key << "meta_managers" << YAML::Value;
+        emitter << YAML::BeginSeq;
+        for (auto& meta_manager_pair : m_generative_manager->m_meta_managers) {
+            emitter << YAML::BeginMap;
+            ID manager_id = meta_manager_pair.first;
+            MetaManager& meta_manager = meta_manager_pair.second;
+            emitter << YAML::Key << "uml_root" << YAML::Value << meta_manager.get_generation_root().id().string();
+            emitter << YAML::Key << "id" << YAML::Value << manager_id.string();
+            emitter << YAML::Key << "profile_hash" << YAML::Value << meta_manager.profile_hash();
+            emitter << YAML::Key << "types" << YAML::Value << YAML::Flow;
+            meta_manager.emit_type_table(emitter);
+            // meta elements are emitted a chunk at a time and released once emitted
+            emitter << YAML::Key << "data" << YAML::Value;
+            meta_manager.dump_all_data(emitter, m_generative_manager->m_meta_dump_chunk_size);
+            emitter << YAML::EndMap;
+        }
+        emitter << YAML::EndSeq;
     }
-    emitter << YAML::EndSeq;
     emitter << YAML::EndMap;
-
     return emitter.c_str();
 }
 
@@ -19,6 +19,10 @@
  *  --location, -l : load from and save to the path specified
  *  --duration, -d : run for specified duration in ms
  *  --num-els, -n : max number of elements in memory before releasing
+ *  --socket, -s : also listen on a unix domain socket at the path specified, for clients on the same host
+ *  --accept-threads, -a : number of threads accepting clients on the port, default 1
+ *  --backlog, -b : connections queued by the kernel before being accepted, default 10
+ *  --workers, -w : number of threads handling requests from all clients, default one per hardware thread
  **/
 
 int main(int argc, char* argv[]) {
@@ -26,6 +30,10 @@ int main(int argc, char* argv[]) {
     int port = 8652;
     std::string path = ".";
     std::string location;
+    std::string socketPath;
+    int acceptThreads = 1;
+    int backlog = UML_SERVER_BACKLOG;
+    int workers = UML_SERVER_WORKERS;
     int duration = -1;
     int numEls = UML_SERVER_NUM_ELS;
     srand(static_cast<unsigned int>(time(0)));
@@ -55,6 +63,26 @@ int main(int argc, char* argv[]) {
             i += 2;
             continue;
         }
+        if (strcmp(argv[i], "-s") == 0) {
+            socketPath = argv[i+1];
+            i += 2;
+            continue;
+        }
+        if (strcmp(argv[i], "-a") == 0) {
+            acceptThreads = atoi(argv[i+1]);
+            i += 2;
+            continue;
+        }
+        if (strcmp(argv[i], "-b") == 0) {
+            backlog = atoi(argv[i+1]);
+            i += 2;
+            continue;
+        }
+        if (strcmp(argv[i], "-w") == 0) {
+            workers = atoi(argv[i+1]);
+            i += 2;
+            continue;
+        }
         char* dashDash = (char*) malloc(3);
         memcpy(dashDash, &argv[i][0], 2);
         dashDash[2] = '\0';
@@ -68,6 +96,15 @@ int main(int argc, char* argv[]) {
                 i++;
                 continue;
             }
+            dashDash = (char*)realloc(dashDash, 9);
+            memcpy(dashDash, &argv[i][0], 8);
+            dashDash[8] = '\0';
+            if (strcmp(dashDash, "--socket") == 0) {
+                free(dashDash);
+                socketPath = &argv[i][9];
+                i++;
+                continue;
+            }
             dashDash = (char*)realloc(dashDash, 10);
             memcpy(dashDash, &argv[i][0], 9);
             dashDash[9] = '\0';
@@ -76,6 +113,16 @@ int main(int argc, char* argv[]) {
                 numEls = atoi(&argv[i][10]);
                 i++;
                 continue;
+            } else if (strcmp(dashDash, "--backlog") == 0) {
+                free(dashDash);
+                backlog = atoi(&argv[i][10]);
+                i++;
+                continue;
+            } else if (strcmp(dashDash, "--workers") == 0) {
+                free(dashDash);
+                workers = atoi(&argv[i][10]);
+                i++;
+                continue;
             }
             dashDash = (char*)realloc(dashDash, 11);
             memcpy(dashDash, &argv[i][0], 10);
@@ -100,6 +147,15 @@ int main(int argc, char* argv[]) {
                 i++;
                 continue;
             }
+            dashDash = (char*)realloc(dashDash, 17);
+            memcpy(dashDash, &argv[i][0], 16);
+            dashDash[16] = '\0';
+            if (strcmp(dashDash, "--accept-threads") == 0) {
+                free(dashDash);
+                acceptThreads = atoi(&argv[i][17]);
+                i++;
+                continue;
+            }
         }
         free(dashDash);
         if (i > 0) {
@@ -118,6 +174,12 @@ int main(int argc, char* argv[]) {
             }
         }
         server.setMaxEls(numEls);
+        if (!socketPath.empty()) {
+            server.setSocketPath(socketPath);
+        }
+        server.setAcceptThreads(acceptThreads);
+        server.setBacklog(backlog);
+        server.setWorkers(workers > 0 ? workers : 0);
         server.mount(path);
         server.start();
         std::cout << "server running" << std::endl;
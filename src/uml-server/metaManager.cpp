@@ -2,6 +2,8 @@
 #include "uml-server/metaManager/proxyElement.h"
 #include "uml-server/metaManager/proxyElementSet.h"
 #include "uml-server/constants.h"
+#include <fstream>
+#include <sstream>
 
 using namespace UML;
 using namespace EGM;
@@ -11,6 +13,11 @@ UmlManager::Pointer<UML::Element> get_element_from_uml_manager(AbstractElementPt
     MetaManager::Pointer<MetaElement> meta_ptr = ptr;
     return dynamic_cast<UML::MetaManager&>(meta_ptr->getManager()).getUmlManager().abstractGet(id); 
 }
+
+void mark_uml_representation_stale(AbstractElementPtr ptr) {
+    MetaManager::Pointer<MetaElement> meta_ptr = ptr;
+    dynamic_cast<UML::MetaManager&>(meta_ptr->getManager()).mark_uml_representation_stale(ptr.id());
+}
 }
 AbstractElementPtr MetaElementSerializationPolicy::parse_meta_element_node(YAML::Node node, std::function<EGM::AbstractElementPtr(std::size_t,EGM::ID)> f) {
     auto it = node.begin();
@@ -24,7 +31,7 @@ AbstractElementPtr MetaElementSerializationPolicy::parse_meta_element_node(YAML:
                 if (valNode["id"] && valNode["id"].IsScalar()) {
                     el_id = EGM::ID::fromString(valNode["id"].template as<std::string>());
                 }
-                auto el = f(this->m_meta_manager->m_name_to_type.at(keyNode.as<std::string>()), el_id);
+                auto el = f(this->m_meta_manager->get_type_by_name(keyNode.as<std::string>()).value(), el_id);
                 auto serialization_policy = m_serializationByType.at(0); // get meta manager
                 serialization_policy->parseBody(valNode, el);
                 serialization_policy->parseScope(node, el);
@@ -90,14 +97,15 @@ void MetaElementSerializationPolicy::parse_set(YAML::Node node, std::string set_
                 }
                 dynamic_cast<MetaManager::Implementation<MetaElement>::ProxySingleton&>(set).set(EGM::ID::fromString(set_node.as<std::string>()));
             } else if (set_node.IsSequence()) {
-                if (set.setType() != SetType::SET || set.setType() != SetType::ORDERED_SET) {
+                if (set.setType() != SetType::SET && set.setType() != SetType::ORDERED_SET) {
                     throw EGM::ManagerStateException("improper node given to parse, no expecting a sequence!");
                 }
                 for (auto set_val_node : set_node) {
+                    EGM::ID set_val_id = EGM::ID::fromString(set_val_node.as<std::string>());
                     if (set.setType() == SetType::SET) {
-                        // dynamic_cast<MetaManager::Implementation<MetaElement>::ProxySet&>(set).add(EGM::ID::fromString(set_node.as<std::string>()));
+                        dynamic_cast<MetaManager::Implementation<MetaElement>::ProxySet&>(set).add(set_val_id);
                     } else {
-                        // dynamic_cast<MetaManager::Implementation<MetaElement>::ProxyOrderedSet&>(set).add(EGM::ID::fromString(set_node.as<std::string>()));
+                        dynamic_cast<MetaManager::Implementation<MetaElement>::ProxyOrderedSet&>(set).add(set_val_id);
                     }
                 }
             } else {
@@ -134,7 +142,54 @@ void MetaElementSerializationPolicy::emitIndividual(YAML::Emitter& emitter, EGM:
     emitter << YAML::EndMap;
 }
 
-MetaManager::MetaManager(UmlManager::Implementation<Element>& abstraction_root) : 
+void MetaManager::visit_all_data(std::function<void(BaseManager::Implementation<MetaElement>&)> visit, std::size_t chunk_size) {
+    if (chunk_size == 0) {
+        chunk_size = META_MANAGER_DUMP_CHUNK_SIZE;
+    }
+
+    // copy ids up front, loading elements while iterating could touch m_meta_elements
+    std::vector<EGM::ID> ids(m_meta_elements.begin(), m_meta_elements.end());
+
+    std::vector<MetaElementPtr> chunk;
+    std::vector<EGM::ID> loaded_for_dump;
+    chunk.reserve(chunk_size);
+    loaded_for_dump.reserve(chunk_size);
+
+    for (std::size_t chunk_start = 0; chunk_start < ids.size(); chunk_start += chunk_size) {
+        std::size_t chunk_end = std::min(chunk_start + chunk_size, ids.size());
+
+        for (std::size_t i = chunk_start; i < chunk_end; i++) {
+            if (!loaded(ids[i])) {
+                loaded_for_dump.push_back(ids[i]);
+            }
+            chunk.push_back(get(ids[i]));
+        }
+
+        // emitting goes through the manager (pointers to sets, lazy loads of what is referenced, property names)
+        // so it stays on this thread like the loads do
+        for (auto& meta_element : chunk) {
+            visit(*meta_element);
+        }
+
+        // give back what we loaded so the dump never holds more than a chunk
+        chunk.clear();
+        for (auto& id : loaded_for_dump) {
+            if (loaded(id)) {
+                release(*get(id));
+            }
+        }
+        loaded_for_dump.clear();
+    }
+}
+
+void MetaManager::stream_all_data(std::function<void(std::string&)> consume, std::size_t chunk_size) {
+    visit_all_data([this, &consume](BaseManager::Implementation<MetaElement>& meta_element) {
+        std::string meta_element_data = emit_meta_element(meta_element);
+        consume(meta_element_data);
+    }, chunk_size);
+}
+
+MetaManager::MetaManager(UmlManager::Implementation<Element>& abstraction_root, bool defer_discovery) : 
     m_uml_manager(abstraction_root.getManager())
 {
     
@@ -151,48 +206,303 @@ MetaManager::MetaManager(UmlManager::Implementation<Element>& abstraction_root)
     m_storage_root = m_uml_manager.create<Package>();
    
     // set up types 
-    std::list<UmlManager::Pointer<Element>> queue = { &abstraction_root };
-    std::size_t next_type = 0;
-    while (!queue.empty()) {
-        auto front = queue.front();
-        queue.pop_front();
+    m_discovery_queue = { &abstraction_root };
+    if (!defer_discovery) {
+        discover_types();
+    }
+}
+
+// built in data types are data of meta elements, not types of their own
+static bool is_primitive_type(const EGM::ID& type_id) {
+    return 
+        type_id == boolean_type_id ||
+        type_id == integer_type_id ||
+        type_id == real_type_id ||
+        type_id == string_type_id ||
+        type_id == unlimited_natural_type_id;
+}
+
+bool MetaManager::discover_types(std::size_t max_steps) {
+    std::size_t steps = 0;
+    while (!m_discovery_queue.empty() && steps < max_steps) {
+        auto front = m_discovery_queue.front();
+        m_discovery_queue.pop_front();
+        if (m_discovered.contains(front.id())) {
+            continue;
+        }
+        m_discovered.insert(front.id());
+        steps++;
         if (front->is<Classifier>()) {
             UmlManager::Pointer<Classifier> curr_classifier = front;
-            if (m_id_to_type.count(front.id())) {
-                continue;
+
+            // known classifiers are still walked so that rediscovery picks up new attribute types
+            if (!m_id_to_type.count(front.id())) {
+                m_uml_types.emplace(m_next_type, front);
+                m_id_to_type.emplace(front.id(), m_next_type);
+                m_name_to_type.emplace(front->as<NamedElement>().getName(), m_next_type);
+                m_next_type++;
             }
-            m_uml_types.emplace(next_type, front);
-            m_id_to_type.emplace(front.id(), next_type);
-            m_name_to_type.emplace(front->as<NamedElement>().getName(), next_type);
-            next_type++;
             for (auto prop : curr_classifier->getAttributes().ptrs()) {
-                if (prop->getType()) {
-                    
-                    // check if built in data type
-                    const EGM::ID& type_id = prop->getType().id();
-                    if (
-                        type_id == boolean_type_id ||
-                        type_id == integer_type_id ||
-                        type_id == real_type_id ||
-                        type_id == string_type_id ||
-                        type_id == unlimited_natural_type_id
-                    ) 
-                        continue;
-                   
-                     queue.push_back(prop->getType());
+                if (prop->getType() && !is_primitive_type(prop->getType().id())) {
+                    m_discovery_queue.push_back(prop->getType());
                 }
             }
             for (auto base : curr_classifier->getGenerals().ptrs()) {
-                queue.push_back(base);
+                m_discovery_queue.push_back(base);
             }
         }
         if (front->is<Package>()) {
             UmlManager::Pointer<Package> package = front;
             for (auto packagedEl : package->getPackagedElements().ptrs()) {
-                queue.push_back(packagedEl);
+                m_discovery_queue.push_back(packagedEl);
+            }
+        }
+    }
+
+    return m_discovery_queue.empty();
+}
+
+void MetaManager::rediscover_types() {
+    // walked elements are skipped, so only the changed ones and what they newly reach are walked again
+    for (auto& changed_id : m_changed_since_discovery) {
+        m_discovered.erase(changed_id);
+        m_discovery_queue.push_back(m_uml_manager.abstractGet(changed_id));
+    }
+    m_changed_since_discovery.clear();
+}
+
+void MetaManager::element_changed(EGM::ID element_id, EGM::ID owner_id) {
+    // an element discovery never reached can't change what this manager's types are
+    if (m_discovered.contains(element_id)) {
+        m_changed_since_discovery.insert(element_id);
+    }
+    if (owner_id != EGM::ID::nullID() && m_discovered.contains(owner_id)) {
+        m_changed_since_discovery.insert(owner_id);
+    }
+}
+
+void MetaManager::element_erased(EGM::ID element_id) {
+    m_changed_since_discovery.erase(element_id);
+    m_discovered.erase(element_id);
+}
+
+// fnv-1a, std::hash is not guaranteed to give the same value between runs
+static void hash_combine(std::uint64_t& hash, const std::string& data) {
+    for (char c : data) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 1099511628211ull;
+    }
+    hash ^= 0xff;
+    hash *= 1099511628211ull;
+}
+
+static const std::uint64_t FNV_OFFSET = 14695981039346656037ull;
+
+static std::string classifier_shape(UmlManager::Pointer<Classifier> classifier) {
+    std::uint64_t hash = FNV_OFFSET;
+    hash_combine(hash, classifier->getName());
+    for (auto attribute : classifier->getAttributes().ptrs()) {
+        hash_combine(hash, attribute.id().string());
+        hash_combine(hash, attribute->getName());
+        hash_combine(hash, attribute->getType() ? attribute->getType().id().string() : "");
+    }
+    for (auto& general_id : classifier->getGenerals().ids()) {
+        hash_combine(hash, general_id.string());
+    }
+    return std::to_string(hash);
+}
+
+static void hash_type(std::uint64_t& hash, std::size_t type, const std::string& classifier_id, const std::string& shape) {
+    hash_combine(hash, std::to_string(type));
+    hash_combine(hash, classifier_id);
+    hash_combine(hash, shape);
+}
+
+std::string MetaManager::type_shape(std::size_t type) {
+    auto unchecked_match = m_unchecked_shapes.find(type);
+    if (unchecked_match != m_unchecked_shapes.end()) {
+        return unchecked_match->second;
+    }
+    return classifier_shape(m_uml_types.at(type));
+}
+
+std::string MetaManager::profile_hash() {
+    std::uint64_t hash = FNV_OFFSET;
+    hash_combine(hash, m_generation_root.id().string());
+    for (std::size_t type = 0; type < m_next_type; type++) {
+        auto type_match = m_uml_types.find(type);
+        if (type_match == m_uml_types.end()) {
+            continue;
+        }
+        hash_type(hash, type, type_match->second.id().string(), type_shape(type));
+    }
+    return std::to_string(hash);
+}
+
+void MetaManager::check_type(std::size_t type) {
+    auto unchecked_match = m_unchecked_shapes.find(type);
+    if (unchecked_match == m_unchecked_shapes.end()) {
+        return;
+    }
+    std::string saved_shape = std::move(unchecked_match->second);
+    m_unchecked_shapes.erase(unchecked_match);
+    auto classifier = m_uml_types.at(type);
+    if (classifier_shape(classifier) != saved_shape) {
+        // the profile changed since the table was saved, no meta element of the type exists yet so the names
+        // can still be taken from the classifier
+        std::erase_if(m_name_to_type, [type](auto& name_pair) { return name_pair.second == type; });
+        m_name_to_type.emplace(classifier->getName(), type);
+        m_property_names[type].clear();
+        walk_loaded_table();
+    }
+    for (auto& general_id : classifier->getGenerals().ids()) {
+        auto general_match = m_id_to_type.find(general_id);
+        if (general_match != m_id_to_type.end()) {
+            check_type(general_match->second);
+        }
+    }
+}
+
+void MetaManager::walk_loaded_table() {
+    if (!m_table_unwalked) {
+        return;
+    }
+    m_table_unwalked = false;
+    m_discovered.clear();
+    m_discovery_queue = { m_generation_root };
+    discover_types();
+
+    // a renamed classifier is only found under its new name once checked
+    std::vector<std::size_t> unchecked_types;
+    for (auto& unchecked_pair : m_unchecked_shapes) {
+        unchecked_types.push_back(unchecked_pair.first);
+    }
+    for (std::size_t type : unchecked_types) {
+        check_type(type);
+    }
+}
+
+UmlManager::Pointer<Classifier> MetaManager::uml_type(std::size_t type) {
+    check_type(type);
+    return m_uml_types.at(type);
+}
+
+std::optional<std::size_t> MetaManager::get_type_by_name(std::string name) {
+    auto match = m_name_to_type.find(name);
+    if (match != m_name_to_type.end() && m_unchecked_shapes.contains(match->second)) {
+        // the classifier may have been renamed since the table was saved
+        check_type(match->second);
+        match = m_name_to_type.find(name);
+    }
+    if (match == m_name_to_type.end() && m_table_unwalked) {
+        walk_loaded_table();
+        match = m_name_to_type.find(name);
+    }
+    if (match != m_name_to_type.end()) {
+        return match->second;
+    }
+    return std::nullopt;
+}
+
+std::optional<std::size_t> MetaManager::get_type_with_id(EGM::ID id) {
+    auto match = m_id_to_type.find(id);
+    if (match == m_id_to_type.end() && m_table_unwalked) {
+        walk_loaded_table();
+        match = m_id_to_type.find(id);
+    }
+    if (match != m_id_to_type.end()) {
+        return match->second;
+    }
+    return std::nullopt;
+}
+
+void MetaManager::rename_property(EGM::ID property_id, const std::string& name) {
+    // the tables are shared by every meta element of their type, so updating them is enough
+    for (auto& property_names_pair : m_property_names) {
+        auto name_match = property_names_pair.second.find(property_id);
+        if (name_match != property_names_pair.second.end()) {
+            name_match->second = name;
+        }
+    }
+}
+
+void MetaManager::emit_type_table(YAML::Emitter& emitter) {
+    emitter << YAML::BeginSeq;
+    for (std::size_t type = 0; type < m_next_type; type++) {
+        auto type_match = m_uml_types.find(type);
+        if (type_match == m_uml_types.end()) {
+            continue;
+        }
+        emitter << YAML::BeginMap;
+        emitter << YAML::Key << "type" << YAML::Value << type;
+        emitter << YAML::Key << "id" << YAML::Value << type_match->second.id().string();
+        emitter << YAML::Key << "name" << YAML::Value << type_match->second->getName();
+        emitter << YAML::Key << "shape" << YAML::Value << type_shape(type);
+        auto property_names_match = m_property_names.find(type);
+        if (property_names_match != m_property_names.end() && !property_names_match->second.empty()) {
+            emitter << YAML::Key << "properties" << YAML::Value << YAML::BeginMap;
+            for (auto& property_pair : property_names_match->second) {
+                emitter << YAML::Key << property_pair.first.string() << YAML::Value << property_pair.second;
+            }
+            emitter << YAML::EndMap;
+        }
+        emitter << YAML::EndMap;
+    }
+    emitter << YAML::EndSeq;
+}
+
+bool MetaManager::load_type_table(YAML::Node types_node, std::string expected_hash) {
+    if (!types_node.IsSequence()) {
+        throw ManagerStateException("Invalid format for meta_manager types, must be a sequence! line " + std::to_string(types_node.Mark().line));
+    }
+
+    // the table is checked against the hash it was saved with, nothing of the profile is loaded, each classifier is
+    // checked against the shape it was saved with the first time its type is used
+    std::uint64_t hash = FNV_OFFSET;
+    hash_combine(hash, m_generation_root.id().string());
+    for (auto type_node : types_node) {
+        if (!type_node["type"] || !type_node["id"] || !type_node["name"]) {
+            throw ManagerStateException("Invalid format for meta_manager type, needs a type, id and name! line " + std::to_string(type_node.Mark().line));
+        }
+        if (!type_node["shape"]) {
+            return false;
+        }
+        hash_type(hash, type_node["type"].as<std::size_t>(), type_node["id"].as<std::string>(), type_node["shape"].as<std::string>());
+    }
+    if (std::to_string(hash) != expected_hash) {
+        return false;
+    }
+
+    for (auto type_node : types_node) {
+        std::size_t type = type_node["type"].as<std::size_t>();
+        EGM::ID classifier_id = EGM::ID::fromString(type_node["id"].as<std::string>());
+        UmlManager::Pointer<Classifier> classifier = m_uml_manager.createPtr(classifier_id);
+        m_uml_types.emplace(type, classifier);
+        m_id_to_type.emplace(classifier_id, type);
+        m_name_to_type.emplace(type_node["name"].as<std::string>(), type);
+        m_unchecked_shapes.emplace(type, type_node["shape"].as<std::string>());
+        if (type_node["properties"] && type_node["properties"].IsMap()) {
+            auto& property_names = m_property_names[type];
+            for (auto property_pair : type_node["properties"]) {
+                property_names.emplace(
+                    EGM::ID::fromString(property_pair.first.as<std::string>()), 
+                    property_pair.second.as<std::string>()
+                );
             }
         }
+        m_next_type = std::max(m_next_type, type + 1);
+    }
+
+    // nothing left to discover unless a type is asked for that the table does not have, changes to the generation
+    // root or a classifier of the table still extend this manager through rediscovery
+    m_discovery_queue.clear();
+    m_discovered = { m_generation_root.id() };
+    for (auto& id_pair : m_id_to_type) {
+        m_discovered.insert(id_pair.first);
     }
+    m_changed_since_discovery.clear();
+    m_table_unwalked = true;
+    return true;
 }
 
 using MetaElementImpl = MetaManager::Implementation<MetaElement>;
@@ -397,7 +707,33 @@ std::unique_ptr<AbstractSet> create_meta_set(EGM::ID type_id, MetaManager::Imple
     return std::make_unique<MetaElementSet<MetaManager::GenBaseHierarchy<MetaElement>, SetType>>(&meta_el);
 }
 
-MetaManager::Pointer<MetaElement> MetaManager::create_meta_element_object(std::size_t element_type, UmlManager::Pointer<Element> applying_element) {
+std::vector<UmlManager::Pointer<Property>> MetaManager::typed_attributes(std::size_t element_type) {
+    // attributes of the type and of every general it inherits from, in the order meta elements lay them out
+    std::vector<UmlManager::Pointer<Property>> ret;
+    std::list<UmlManager::Pointer<Classifier>> queue = { uml_type(element_type) };
+    while (!queue.empty()) {
+        auto front = queue.front();
+        queue.pop_front();
+        for (auto property : front->getAttributes().ptrs()) {
+            if (!property->getType()) {
+                // TODO log error
+                continue;
+            }
+            ret.push_back(property);
+        }
+        for (auto base : front->getGenerals().ptrs()) {
+            queue.push_back(base);
+        }
+    }
+    return ret;
+}
+
+MetaManager::Pointer<MetaElement> MetaManager::create_meta_element_object(
+        std::size_t element_type, 
+        UmlManager::Pointer<Element> applying_element, 
+        const std::vector<UmlManager::Pointer<Property>>* attributes
+    ) 
+{
     auto meta_element = BaseManager::create<MetaElement>();
 
     if (next_id != EGM::ID::nullID()) {
@@ -408,7 +744,7 @@ MetaManager::Pointer<MetaElement> MetaManager::create_meta_element_object(std::s
     m_meta_elements.insert(meta_element.id());
     
     // get representing classifier
-    auto meta_type = m_uml_types.at(element_type);
+    auto meta_type = uml_type(element_type);
     meta_element->meta_type = meta_type;
 
     // set name
@@ -417,6 +753,10 @@ MetaManager::Pointer<MetaElement> MetaManager::create_meta_element_object(std::s
     // mark applying element (stereotyped element) if exists
     meta_element->applying_element = applying_element;
 
+    // share the property name table of this type so emitting never has to look names up
+    auto& property_names = m_property_names[element_type];
+    meta_element->property_names = &property_names;
+
     // set bases
     for (auto base : meta_type->getGenerals().ptrs()) {
         meta_element->m_bases.push_back(m_id_to_type.at(base.id()));
@@ -425,7 +765,7 @@ MetaManager::Pointer<MetaElement> MetaManager::create_meta_element_object(std::s
     // reusable lambda for creating a property corresponding to a set
     // returns ptr to set
     std::function<EGM::AbstractSet*(UmlManager::Pointer<Property>)> create_property_set;
-    create_property_set = [meta_element, applying_element, this, &create_property_set](UmlManager::Pointer<Property> property) -> EGM::AbstractSet* {
+    create_property_set = [meta_element, applying_element, this, &property_names, &create_property_set](UmlManager::Pointer<Property> property) -> EGM::AbstractSet* {
         // check if already created
         auto property_sets_it = meta_element->sets.find(property.id());
         if (property_sets_it != meta_element->sets.end()) {
@@ -440,6 +780,8 @@ MetaManager::Pointer<MetaElement> MetaManager::create_meta_element_object(std::s
             }
         }
         
+        property_names.try_emplace(property.id(), property->getName());
+
         auto upper_value_spec = property->getUpperValue();
         std::optional<int> upper_value = std::nullopt;
         if (upper_value_spec && upper_value_spec->is<LiteralInteger>()) {
@@ -482,73 +824,65 @@ MetaManager::Pointer<MetaElement> MetaManager::create_meta_element_object(std::s
     };
 
     // set sets
-    std::list<UmlManager::Pointer<Classifier>> queue = { meta_type };
-    while (!queue.empty()) {
-        auto front = queue.front();
-        queue.pop_front();
-        for (auto property : front->getAttributes().ptrs()) {
-            
-            auto property_type = property->getType();
-            if (!property_type) {
-                // TODO log error
-                continue;
+    std::vector<UmlManager::Pointer<Property>> own_attributes;
+    if (!attributes) {
+        own_attributes = typed_attributes(element_type);
+        attributes = &own_attributes;
+    }
+    for (auto& property : *attributes) {
+        auto property_type = property->getType();
+        property_names.try_emplace(property.id(), property->getName());
+
+        // see if the type is primitive type or not to figure out whether to map
+        // the property to a set or to data
+        const EGM::ID& type_id = property_type.id();
+        if (type_id == boolean_type_id) {
+            bool initial_value = false;
+            auto default_value = property->getDefaultValue();
+            if (default_value && default_value->is<LiteralBoolean>()) {
+                initial_value = default_value->as<LiteralBoolean>().getValue();
             }
 
-            // see if the type is primitive type or not to figure out whether to map
-            // the property to a set or to data
-            const EGM::ID& type_id = property_type.id();
-            if (type_id == boolean_type_id) {
-                bool initial_value = false;
-                auto default_value = property->getDefaultValue();
-                if (default_value && default_value->is<LiteralBoolean>()) {
-                    initial_value = default_value->as<LiteralBoolean>().getValue();
-                }
-
-                auto data_policy = std::make_unique<MetaManagerBooleanDataPolicy>(initial_value);
-                data_policy->defining_feature = property;
-                meta_element->data.emplace(property.id(), std::move(data_policy));
-            } else if (type_id == integer_type_id) {
-                int initial_value = 0;
-                auto default_value = property->getDefaultValue();
-                if (default_value && default_value->is<LiteralInteger>()) {
-                    initial_value = default_value->as<LiteralInteger>().getValue();
-                }
-
-                
-                auto data_policy = std::make_unique<IntegerDataPolicy>(initial_value);
-                data_policy->defining_feature = property;
-                meta_element->data.emplace(property.id(), std::move(data_policy));
-            } else if (type_id == real_type_id) {
-                double initial_value = 0;
-                auto default_value = property->getDefaultValue();
-                if (default_value && default_value->is<LiteralReal>()) {
-                    initial_value = default_value->as<LiteralReal>().getValue();
-                }
+            auto data_policy = std::make_unique<MetaManagerBooleanDataPolicy>(initial_value);
+            data_policy->defining_feature = property;
+            meta_element->data.emplace(property.id(), std::move(data_policy));
+        } else if (type_id == integer_type_id) {
+            int initial_value = 0;
+            auto default_value = property->getDefaultValue();
+            if (default_value && default_value->is<LiteralInteger>()) {
+                initial_value = default_value->as<LiteralInteger>().getValue();
+            }
 
-                
-                auto data_policy = std::make_unique<RealDataPolicy>(initial_value);
-                data_policy->defining_feature = property;
-                meta_element->data.emplace(property.id(), std::move(data_policy));
-            } else if (type_id == string_type_id) {
-                std::string initial_value = "";
-                auto default_value = property->getDefaultValue();
-                if (default_value && default_value->is<LiteralString>()) {
-                    initial_value = default_value->as<LiteralString>().getValue();
-                }
+            
+            auto data_policy = std::make_unique<IntegerDataPolicy>(initial_value);
+            data_policy->defining_feature = property;
+            meta_element->data.emplace(property.id(), std::move(data_policy));
+        } else if (type_id == real_type_id) {
+            double initial_value = 0;
+            auto default_value = property->getDefaultValue();
+            if (default_value && default_value->is<LiteralReal>()) {
+                initial_value = default_value->as<LiteralReal>().getValue();
+            }
 
-                
-                auto data_policy = std::make_unique<StringDataPolicy>(initial_value);
-                data_policy->defining_feature = property;
-                meta_element->data.emplace(property.id(), std::move(data_policy));
-            } else if (type_id == unlimited_natural_type_id) {
-                throw EGM::ManagerStateException("TODO Unlimited Natural");
-            } else {
-                create_property_set(property);
+            
+            auto data_policy = std::make_unique<RealDataPolicy>(initial_value);
+            data_policy->defining_feature = property;
+            meta_element->data.emplace(property.id(), std::move(data_policy));
+        } else if (type_id == string_type_id) {
+            std::string initial_value = "";
+            auto default_value = property->getDefaultValue();
+            if (default_value && default_value->is<LiteralString>()) {
+                initial_value = default_value->as<LiteralString>().getValue();
             }
-        }
 
-        for (auto base : front->getGenerals().ptrs()) {
-            queue.push_back(base);
+            
+            auto data_policy = std::make_unique<StringDataPolicy>(initial_value);
+            data_policy->defining_feature = property;
+            meta_element->data.emplace(property.id(), std::move(data_policy));
+        } else if (type_id == unlimited_natural_type_id) {
+            throw EGM::ManagerStateException("TODO Unlimited Natural");
+        } else {
+            create_property_set(property);
         }
     }
 
@@ -559,18 +893,247 @@ MetaManager::Pointer<MetaElement> MetaManager::create_meta_element_object(std::s
 // element_type - element_type of meta_element
 // applying_element - pointer (can be null) to element applying meta_element to as stereotype
 // return - the meta_element created as a ptr
-EGM::AbstractElementPtr MetaManager::create_meta_element(std::size_t element_type, UmlManager::Pointer<Element> applying_element) {
-    auto meta_element = create_meta_element_object(element_type, applying_element); 
+EGM::AbstractElementPtr MetaManager::create_meta_element(
+        std::size_t element_type, 
+        UmlManager::Pointer<Element> applying_element, 
+        const std::vector<UmlManager::Pointer<Property>>* attributes
+    ) 
+{
+    auto meta_element = create_meta_element_object(element_type, applying_element, attributes); 
     create_uml_representation(meta_element); 
 
     if (applying_element) {
         m_stereotyped_elements.emplace(applying_element.id(), applying_element);
+        index_application(meta_element.id(), applying_element.id());
     }
 
     return meta_element; 
 }
 
+std::vector<MetaManager::MetaElementPtr> MetaManager::apply_all(std::vector<UmlManager::Pointer<Element>>& applying_elements, std::size_t stereotype_type) {
+    // the stereotype and its generals are walked once for the whole batch, which also makes sure the type
+    // is valid before anything is created
+    auto attributes = typed_attributes(stereotype_type);
+
+    std::vector<MetaElementPtr> ret;
+    ret.reserve(applying_elements.size());
+    m_stereotyped_elements.reserve(m_stereotyped_elements.size() + applying_elements.size());
+    m_applying_elements.reserve(m_applying_elements.size() + applying_elements.size());
+    m_meta_elements.reserve(m_meta_elements.size() + applying_elements.size());
+    for (auto& applying_element : applying_elements) {
+        ret.push_back(create_meta_element(stereotype_type, applying_element, &attributes));
+    }
+    return ret;
+}
+
+void MetaManager::index_application(EGM::ID meta_element_id, EGM::ID applying_element_id) {
+    m_applying_elements[meta_element_id] = applying_element_id;
+    m_applied_meta_elements[applying_element_id].push_back(meta_element_id);
+}
+
+void MetaManager::unindex_application(EGM::ID meta_element_id) {
+    auto applying_match = m_applying_elements.find(meta_element_id);
+    if (applying_match == m_applying_elements.end()) {
+        return;
+    }
+    auto applied_match = m_applied_meta_elements.find(applying_match->second);
+    if (applied_match != m_applied_meta_elements.end()) {
+        std::erase(applied_match->second, meta_element_id);
+        if (applied_match->second.empty()) {
+            m_applied_meta_elements.erase(applied_match);
+        }
+    }
+    m_applying_elements.erase(applying_match);
+}
+
+MetaManager::MetaElementPtr MetaManager::restore_meta_element(UmlManager::Pointer<Element> applying_element, std::string& data) {
+    return parse_meta_element_node(YAML::Load(data), [this, applying_element](std::size_t element_type, EGM::ID element_id) -> AbstractElementPtr {
+        next_id = element_id;
+        auto meta_element = create_meta_element_object(element_type, applying_element);
+
+        // the instance has the same id, leave it unloaded until something needs it
+        meta_element->uml_representation = m_uml_manager.createPtr(element_id);
+        return meta_element;
+    });
+}
+
+template <template <class> class Literal, class Value>
+void set_literal_slot_value(ManagerTypes<UmlTypes>& uml_manager, UmlManager::Pointer<Slot> slot, Value value) {
+    auto slot_value = uml_manager.create<Literal>();
+    slot_value->setValue(value);
+    slot->getValues().add(slot_value);
+}
+
+void MetaManager::sync_uml_representation(MetaElementPtr meta_element) {
+    UmlManager::Pointer<InstanceSpecification> instance = m_uml_manager.abstractGet(meta_element.id());
+    meta_element->uml_representation = instance;
+
+    std::unordered_map<EGM::ID, UmlManager::Pointer<Slot>> slots;
+    for (auto slot : instance->getSlots().ptrs()) {
+        slots.emplace(slot->getDefiningFeature().id(), slot);
+    }
+
+    // find the slot for a property with its values cleared, or make a new one
+    auto get_empty_slot = [this, &slots, &instance](UmlManager::Pointer<Property> property) -> UmlManager::Pointer<Slot> {
+        auto slot_match = slots.find(property.id());
+        if (slot_match == slots.end()) {
+            auto slot = m_uml_manager.create<Slot>();
+            slot->setDefiningFeature(property);
+            instance->getSlots().add(slot);
+            return slot;
+        }
+        auto slot = slot_match->second;
+        std::vector<UmlManager::Pointer<ValueSpecification>> values;
+        for (auto value : slot->getValues().ptrs()) {
+            values.push_back(value);
+        }
+        for (auto& value : values) {
+            m_uml_manager.erase(*value);
+        }
+        return slot;
+    };
+
+    for (auto& set_pair : meta_element->sets) {
+        auto* set_policy = dynamic_cast<MetaElementSetPolicy<MetaManager::GenBaseHierarchy<MetaElement>>*>(set_pair.second.get());
+        if (!set_policy) {
+            continue;
+        }
+
+        UmlManager::Pointer<Property> property = meta_element->meta_type->getAttributes().get(set_pair.first);
+        auto slot = get_empty_slot(property);
+        for (auto it = set_pair.second->beginPtr(); *it != *set_pair.second->endPtr(); it->next()) {
+            auto inst_val = m_uml_manager.create<InstanceValue>();
+            inst_val->setInstance(it->getCurr().id());
+            slot->getValues().add(inst_val);
+        }
+
+        // relink so further changes go straight to the slot
+        set_policy->uml_manager = &m_uml_manager;
+        set_policy->uml_slot = slot;
+    }
+
+    for (auto& data_pair : meta_element->data) {
+        auto& primitive_policy = dynamic_cast<AbstractPrimitivePolicy&>(*data_pair.second);
+        auto slot = get_empty_slot(primitive_policy.defining_feature);
+        switch (primitive_policy.primitive()) {
+            case PrimitivePolicyType::BOOLEAN:
+                set_literal_slot_value<LiteralBoolean>(m_uml_manager, slot, dynamic_cast<MetaManagerBooleanDataPolicy&>(primitive_policy).m_val);
+                break;
+            case PrimitivePolicyType::INTEGER:
+                set_literal_slot_value<LiteralInteger>(m_uml_manager, slot, dynamic_cast<IntegerDataPolicy&>(primitive_policy).m_val);
+                break;
+            case PrimitivePolicyType::STRING:
+                set_literal_slot_value<LiteralString>(m_uml_manager, slot, dynamic_cast<StringDataPolicy&>(primitive_policy).m_val);
+                break;
+            case PrimitivePolicyType::REAL:
+                set_literal_slot_value<LiteralReal>(m_uml_manager, slot, dynamic_cast<RealDataPolicy&>(primitive_policy).m_val);
+                break;
+            default:
+                throw ManagerStateException("Could not process primitive type!");
+        }
+    }
+}
+
+void MetaManager::sync_uml_representations() {
+    std::vector<EGM::ID> stale_ids(m_stale_uml_representations.begin(), m_stale_uml_representations.end());
+    m_stale_uml_representations.clear();
+    for (auto& id : stale_ids) {
+        if (!m_meta_elements.contains(id)) {
+            continue;
+        }
+        bool was_loaded = loaded(id);
+        MetaElementPtr meta_element = get(id);
+        sync_uml_representation(meta_element);
+        if (!was_loaded) {
+            release(*meta_element);
+        }
+    }
+}
+
+void MetaManager::release_resident(EGM::ID id) {
+    if (!loaded(id)) {
+        return;
+    }
+
+    if (!m_meta_elements.contains(id)) {
+        release(*get(id));
+        return;
+    }
+
+    MetaElementPtr meta_element = get(id);
+    EGM::ID uml_representation_id = meta_element->uml_representation.id();
+    release(*meta_element);
+
+    // the mirror is restored from its own id whenever the meta element needs it again
+    if (uml_representation_id == EGM::ID::nullID() || !m_uml_manager.loaded(uml_representation_id)) {
+        return;
+    }
+    UmlManager::Pointer<InstanceSpecification> instance = m_uml_manager.abstractGet(uml_representation_id);
+    std::vector<EGM::ID> slot_ids;
+    for (auto& slot_id : instance->getSlots().ids()) {
+        slot_ids.push_back(slot_id);
+    }
+    m_uml_manager.release(*instance);
+    for (auto& slot_id : slot_ids) {
+        if (!m_uml_manager.loaded(slot_id)) {
+            continue;
+        }
+        UmlManager::Pointer<Slot> slot = m_uml_manager.abstractGet(slot_id);
+        std::vector<EGM::ID> value_ids;
+        for (auto& value_id : slot->getValues().ids()) {
+            value_ids.push_back(value_id);
+        }
+        m_uml_manager.release(*slot);
+        for (auto& value_id : value_ids) {
+            if (m_uml_manager.loaded(value_id)) {
+                m_uml_manager.release(*m_uml_manager.abstractGet(value_id));
+            }
+        }
+    }
+}
+
 AbstractElementPtr MetaElementStoragePolicy::loadElement(ID id) {
+    // proxies only hold the uml element they stand in for
+    auto proxied_match = m_meta_manager->m_proxied_elements.find(id);
+    if (proxied_match != m_meta_manager->m_proxied_elements.end()) {
+        auto proxy_element = m_meta_manager->BaseManager::create<ProxyElement>();
+        proxy_element->setID(id);
+        proxy_element->m_uml_element = m_meta_manager->m_uml_manager.createPtr(proxied_match->second);
+        return proxy_element;
+    }
+
+    auto serialized_match = m_serialized_meta_elements.find(id);
+    if (serialized_match == m_serialized_meta_elements.end()) {
+        return load_from_uml_representation(id);
+    }
+
+    // restore from our own serialized form, nothing referenced is loaded here
+    auto& serialized = serialized_match->second;
+    if (serialized.on_disk) {
+        std::ifstream record_file(record_path(id));
+        std::stringstream record_stream;
+        record_stream << record_file.rdbuf();
+        if (!record_file) {
+            throw ManagerStateException("could not read serialized meta element " + id.string());
+        }
+        serialized.data = record_stream.str();
+    }
+    UmlManager::Pointer<Element> applying_element;
+    if (serialized.applying_element != ID::nullID()) {
+        applying_element = m_meta_manager->m_uml_manager.createPtr(serialized.applying_element);
+    }
+    bool was_stale = m_meta_manager->m_stale_uml_representations.contains(id);
+    auto meta_element = m_meta_manager->restore_meta_element(applying_element, serialized.data);
+
+    // adding the restored values flags the representation, it only is stale if it was before release
+    if (!was_stale) {
+        m_meta_manager->m_stale_uml_representations.erase(id);
+    }
+    forget_record(serialized_match);
+    return meta_element;
+}
+
+AbstractElementPtr MetaElementStoragePolicy::load_from_uml_representation(ID id) {
     UmlManager::Pointer<Element> uml_element = m_meta_manager->m_uml_manager.abstractGet(id);
 
     if (uml_element->is<InstanceSpecification>()) {
@@ -581,14 +1144,22 @@ AbstractElementPtr MetaElementStoragePolicy::loadElement(ID id) {
             // throw ManagerStateException("no classifier for instance when restoring meta element");
         }
 
-        auto match = m_meta_manager->m_id_to_type.find(classifier.id());
-        if (match == m_meta_manager->m_id_to_type.end()) {
+        auto element_type = m_meta_manager->get_type_with_id(classifier.id());
+        if (!element_type) {
             return uml_element;
             // throw ManagerStateException("not tracking classifier " + classifier.id().string());
         }
 
+        // the instance does not know what it is applied to, the application index does
+        UmlManager::Pointer<Element> applying_element;
+        auto applying_match = m_meta_manager->m_applying_elements.find(id);
+        if (applying_match != m_meta_manager->m_applying_elements.end()) {
+            applying_element = m_meta_manager->m_uml_manager.createPtr(applying_match->second);
+        }
+
         m_meta_manager->next_id = instance.getID();
-        auto meta_element = m_meta_manager->create_meta_element_object(match->second, 0);
+        auto meta_element = m_meta_manager->create_meta_element_object(*element_type, applying_element);
+        meta_element->uml_representation = &instance;
 
         for (auto& slot : instance.getSlots()) {
             auto defining_feature = slot.getDefiningFeature();
@@ -678,8 +1249,69 @@ AbstractElementPtr MetaElementStoragePolicy::loadElement(ID id) {
     // throw ManagerStateException("Could not load meta element");
 }
 void MetaElementStoragePolicy::saveElement(EGM::AbstractElement& el) {
-    // do nothing cause our policies take care of it
+    auto* meta_element = dynamic_cast<MetaElementImpl*>(&el);
+    if (!meta_element) {
+        return;
+    }
+
+    auto serialized_match = m_serialized_meta_elements.find(el.getID());
+    if (serialized_match != m_serialized_meta_elements.end()) {
+        forget_record(serialized_match);
+    }
+    auto& serialized = m_serialized_meta_elements[el.getID()];
+    serialized.applying_element = meta_element->applying_element.id();
+    serialized.data = m_meta_manager->emit_meta_element(*meta_element);
+    m_records_in_memory.push_front(el.getID());
+    serialized.in_memory = m_records_in_memory.begin();
+    spill_records();
 }
+
 void MetaElementStoragePolicy::eraseEl(EGM::ID id) {
-    // handled by overriden method
+    auto serialized_match = m_serialized_meta_elements.find(id);
+    if (serialized_match != m_serialized_meta_elements.end()) {
+        forget_record(serialized_match);
+    }
+    m_meta_manager->m_stale_uml_representations.erase(id);
+    m_meta_manager->unindex_application(id);
+}
+
+MetaElementStoragePolicy::~MetaElementStoragePolicy() {
+    if (!m_record_directory.empty()) {
+        std::error_code ec;
+        std::filesystem::remove_all(m_record_directory, ec);
+    }
+}
+
+std::filesystem::path MetaElementStoragePolicy::record_path(EGM::ID id) {
+    return m_record_directory / (id.string() + ".json");
+}
+
+void MetaElementStoragePolicy::spill_records() {
+    while (m_records_in_memory.size() > m_record_limit) {
+        if (m_record_directory.empty()) {
+            m_record_directory = std::filesystem::temp_directory_path() / ("uml-meta-records-" + EGM::ID::randomID().string());
+            std::filesystem::create_directories(m_record_directory);
+        }
+        EGM::ID oldest_id = m_records_in_memory.back();
+        auto& serialized = m_serialized_meta_elements.at(oldest_id);
+        std::ofstream record_file(record_path(oldest_id), std::ios::trunc);
+        record_file << serialized.data;
+        if (!record_file) {
+            // keep it in memory rather than lose it
+            return;
+        }
+        serialized.on_disk = true;
+        std::string().swap(serialized.data);
+        m_records_in_memory.pop_back();
+    }
+}
+
+void MetaElementStoragePolicy::forget_record(std::unordered_map<EGM::ID, SerializedMetaElement>::iterator record) {
+    if (record->second.on_disk) {
+        std::error_code ec;
+        std::filesystem::remove(record_path(record->first), ec);
+    } else {
+        m_records_in_memory.erase(record->second.in_memory);
+    }
+    m_serialized_meta_elements.erase(record);
 }
@@ -0,0 +1,166 @@
+#include "uml-server/nameIndex.h"
+#include <algorithm>
+#include <cctype>
+#include <tuple>
+
+using namespace EGM;
+
+namespace UML {
+
+std::string NameIndex::to_lower(std::string_view str) {
+    std::string ret(str);
+    for (auto& c : ret) {
+        c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    }
+    return ret;
+}
+
+std::vector<std::string> NameIndex::tokenize(std::string_view name) {
+    std::vector<std::string> tokens;
+    std::string curr;
+    for (std::size_t i = 0; i < name.size(); i++) {
+        unsigned char c = static_cast<unsigned char>(name[i]);
+        if (!std::isalnum(c)) {
+            if (!curr.empty()) {
+                tokens.push_back(to_lower(curr));
+                curr.clear();
+            }
+            continue;
+        }
+
+        // split camel case, fooBar -> foo bar
+        if (std::isupper(c) && !curr.empty() && std::islower(static_cast<unsigned char>(curr.back()))) {
+            tokens.push_back(to_lower(curr));
+            curr.clear();
+        }
+        curr += name[i];
+    }
+    if (!curr.empty()) {
+        tokens.push_back(to_lower(curr));
+    }
+    return tokens;
+}
+
+void NameIndex::remove_key(IdsByKey& ids_by_key, const std::string& key, ID id) {
+    auto match = ids_by_key.find(key);
+    if (match == ids_by_key.end()) {
+        return;
+    }
+    match->second.erase(id);
+    if (match->second.empty()) {
+        ids_by_key.erase(match);
+    }
+}
+
+void NameIndex::index(ID id, std::string name) {
+    auto name_match = m_names.find(id);
+    if (name_match != m_names.end()) {
+        if (name_match->second == name) {
+            return;
+        }
+        unindex(id);
+    }
+    if (name.empty()) {
+        return;
+    }
+
+    m_by_name[to_lower(name)].insert(id);
+    for (auto& token : tokenize(name)) {
+        m_by_token[token].insert(id);
+    }
+    m_names.emplace(id, std::move(name));
+}
+
+void NameIndex::unindex(ID id) {
+    auto name_match = m_names.find(id);
+    if (name_match == m_names.end()) {
+        return;
+    }
+    remove_key(m_by_name, to_lower(name_match->second), id);
+    for (auto& token : tokenize(name_match->second)) {
+        remove_key(m_by_token, token, id);
+    }
+    m_names.erase(name_match);
+}
+
+void NameIndex::clear() {
+    m_names.clear();
+    m_by_name.clear();
+    m_by_token.clear();
+}
+
+std::vector<ID> NameIndex::search(std::string_view query, SearchMode mode, bool case_sensitive, std::size_t limit) const {
+    std::vector<ID> ret;
+    if (query.empty() || limit == 0) {
+        return ret;
+    }
+    std::string lower_query = to_lower(query);
+
+    // keys are visited in rank order (the exact key, then longer names, then words) so the first limit ids
+    // taken are the best ranked ones, ids under a key go in order of their names so results are the same
+    // every time
+    std::unordered_set<ID> seen;
+    auto in_name_order = [this](const std::unordered_set<ID>& ids) {
+        std::vector<std::tuple<std::string_view, std::string, ID>> ordered;
+        ordered.reserve(ids.size());
+        for (auto& id : ids) {
+            ordered.emplace_back(m_names.at(id), id.string(), id);
+        }
+        std::sort(ordered.begin(), ordered.end(), [](const auto& lhs, const auto& rhs) {
+            return std::tie(std::get<0>(lhs), std::get<1>(lhs)) < std::tie(std::get<0>(rhs), std::get<1>(rhs));
+        });
+        std::vector<ID> ret;
+        ret.reserve(ordered.size());
+        for (auto& entry : ordered) {
+            ret.push_back(std::get<2>(entry));
+        }
+        return ret;
+    };
+    auto take = [&](const std::vector<ID>& ids, auto matches) {
+        for (auto& id : ids) {
+            if (ret.size() == limit) {
+                return;
+            }
+            if (matches(m_names.at(id)) && seen.insert(id).second) {
+                ret.push_back(id);
+            }
+        }
+    };
+
+    auto name_it = m_by_name.lower_bound(lower_query);
+    if (name_it != m_by_name.end() && name_it->first == lower_query) {
+        // exact with the same case first, then exact ignoring case
+        auto exact_ids = in_name_order(name_it->second);
+        take(exact_ids, [&query](const std::string& name) { return name == query; });
+        if (!case_sensitive) {
+            take(exact_ids, [](const std::string&) { return true; });
+        }
+        name_it++;
+    }
+    if (mode == SearchMode::EXACT) {
+        return ret;
+    }
+
+    // names starting with query
+    for (; name_it != m_by_name.end() && ret.size() < limit; name_it++) {
+        if (!std::string_view(name_it->first).starts_with(lower_query)) {
+            break;
+        }
+        take(in_name_order(name_it->second), [&query, case_sensitive](const std::string& name) {
+            return !case_sensitive || std::string_view(name).starts_with(query);
+        });
+    }
+
+    // names with a word starting with query
+    for (auto token_it = m_by_token.lower_bound(lower_query); token_it != m_by_token.end() && ret.size() < limit; token_it++) {
+        if (!std::string_view(token_it->first).starts_with(lower_query)) {
+            break;
+        }
+        take(in_name_order(token_it->second), [&query, case_sensitive](const std::string& name) {
+            return !case_sensitive || name.find(query) != std::string::npos;
+        });
+    }
+    return ret;
+}
+
+}
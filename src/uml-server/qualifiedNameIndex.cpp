@@ -0,0 +1,264 @@
+#include "uml-server/qualifiedNameIndex.h"
+
+using namespace EGM;
+
+namespace UML {
+
+std::vector<std::string_view> QualifiedNameIndex::split(std::string_view qualified_name) {
+    std::vector<std::string_view> segments;
+    if (qualified_name.empty()) {
+        return segments;
+    }
+    std::size_t segment_start = 0;
+    while (true) {
+        auto separator_pos = qualified_name.find(SEPARATOR, segment_start);
+        if (separator_pos == std::string_view::npos) {
+            segments.push_back(qualified_name.substr(segment_start));
+            return segments;
+        }
+        segments.push_back(qualified_name.substr(segment_start, separator_pos - segment_start));
+        segment_start = separator_pos + SEPARATOR.size();
+    }
+}
+
+void QualifiedNameIndex::detach(ID id, Entry& entry) {
+    if (entry.owner == ID::nullID()) {
+        return;
+    }
+    auto owner_match = m_entries.find(entry.owner);
+    if (owner_match == m_entries.end()) {
+        return;
+    }
+    auto& owner_entry = owner_match->second;
+    auto name_match = owner_entry.children.find(entry.name);
+    if (name_match != owner_entry.children.end()) {
+        name_match->second.erase(id);
+        if (name_match->second.empty()) {
+            owner_entry.children.erase(name_match);
+        }
+    }
+
+    // drop placeholders once nothing is left in them
+    if (!owner_entry.indexed && owner_entry.children.empty()) {
+        m_entries.erase(owner_match);
+    }
+}
+
+void QualifiedNameIndex::set_root(ID root_id, std::string name) {
+    m_root = root_id;
+    auto root_match = m_entries.find(root_id);
+    if (root_match != m_entries.end()) {
+        detach(root_id, root_match->second);
+    }
+    Entry& root_entry = m_entries[root_id];
+    root_entry.owner = ID::nullID();
+    root_entry.name = std::move(name);
+    root_entry.indexed = true;
+}
+
+void QualifiedNameIndex::index(ID id, std::string name, ID owner) {
+    Entry& entry = m_entries[id];
+    if (entry.indexed) {
+        if (entry.owner == owner && entry.name == name) {
+            return;
+        }
+        detach(id, entry);
+    }
+
+    entry.owner = owner;
+    entry.name = std::move(name);
+    entry.indexed = true;
+    if (owner == ID::nullID()) {
+        return;
+    }
+
+    // the owner may not be indexed yet, hold the child for it until it is
+    m_entries[owner].children[entry.name].insert(id);
+}
+
+void QualifiedNameIndex::erase_subtree(ID id) {
+    auto match = m_entries.find(id);
+    if (match == m_entries.end()) {
+        return;
+    }
+    std::vector<ID> children;
+    for (auto& child_pair : match->second.children) {
+        children.insert(children.end(), child_pair.second.begin(), child_pair.second.end());
+    }
+    m_entries.erase(match);
+    for (auto& child_id : children) {
+        erase_subtree(child_id);
+    }
+}
+
+void QualifiedNameIndex::unindex(ID id) {
+    auto match = m_entries.find(id);
+    if (match == m_entries.end()) {
+        return;
+    }
+    detach(id, match->second);
+    erase_subtree(id);
+    if (id == m_root) {
+        m_root = ID::nullID();
+    }
+}
+
+void QualifiedNameIndex::clear() {
+    m_entries.clear();
+    m_root = ID::nullID();
+}
+
+bool QualifiedNameIndex::contains(ID id) const {
+    auto match = m_entries.find(id);
+    return match != m_entries.end() && match->second.indexed;
+}
+
+std::optional<ID> QualifiedNameIndex::owner_of(ID id) const {
+    auto match = m_entries.find(id);
+    if (match == m_entries.end() || !match->second.indexed) {
+        return std::nullopt;
+    }
+    return match->second.owner;
+}
+
+bool QualifiedNameIndex::owned_by(ID id, ID ancestor) const {
+    auto match = m_entries.find(id);
+    while (match != m_entries.end() && match->second.owner != ID::nullID()) {
+        if (match->second.owner == ancestor) {
+            return true;
+        }
+        match = m_entries.find(match->second.owner);
+    }
+    return false;
+}
+
+void QualifiedNameIndex::for_each_owned(ID id, std::function<void(ID)> f) const {
+    std::vector<ID> stack = { id };
+    while (!stack.empty()) {
+        auto match = m_entries.find(stack.back());
+        stack.pop_back();
+        if (match == m_entries.end()) {
+            continue;
+        }
+        for (auto& child_pair : match->second.children) {
+            for (auto& child_id : child_pair.second) {
+                f(child_id);
+                stack.push_back(child_id);
+            }
+        }
+    }
+}
+
+const QualifiedNameIndex::Entry* QualifiedNameIndex::find_entry(std::vector<std::string_view>& segments) const {
+    auto root_match = m_entries.find(m_root);
+    if (root_match == m_entries.end() || segments.empty() || segments.front() != root_match->second.name) {
+        return 0;
+    }
+    const Entry* curr = &root_match->second;
+    for (std::size_t i = 1; i < segments.size(); i++) {
+        auto child_match = curr->children.find(segments[i]);
+        if (child_match == curr->children.end() || child_match->second.size() != 1) {
+            return 0;
+        }
+        auto entry_match = m_entries.find(*child_match->second.begin());
+        if (entry_match == m_entries.end()) {
+            return 0;
+        }
+        curr = &entry_match->second;
+    }
+    return curr;
+}
+
+std::optional<ID> QualifiedNameIndex::lookup(std::string_view qualified_name) const {
+    if (m_root == ID::nullID()) {
+        return std::nullopt;
+    }
+    if (qualified_name.empty()) {
+        return m_root;
+    }
+
+    auto segments = split(qualified_name);
+    if (segments.size() == 1) {
+        if (find_entry(segments)) {
+            return m_root;
+        }
+        return std::nullopt;
+    }
+
+    // resolve the owner, then pick the element out of its children
+    std::string_view last_segment = segments.back();
+    segments.pop_back();
+    const Entry* owner_entry = find_entry(segments);
+    if (!owner_entry) {
+        return std::nullopt;
+    }
+    auto child_match = owner_entry->children.find(last_segment);
+    if (child_match == owner_entry->children.end() || child_match->second.size() != 1) {
+        return std::nullopt;
+    }
+    return *child_match->second.begin();
+}
+
+std::vector<ID> QualifiedNameIndex::lookup_prefix(std::string_view prefix, std::size_t limit) const {
+    std::vector<ID> ret;
+    auto segments = split(prefix);
+    if (segments.empty() || limit == 0) {
+        if (m_root != ID::nullID() && limit != 0) {
+            ret.push_back(m_root);
+        }
+        return ret;
+    }
+
+    std::string_view partial_segment = segments.back();
+    segments.pop_back();
+    if (segments.empty()) {
+        auto root_match = m_entries.find(m_root);
+        if (root_match != m_entries.end() && root_match->second.name.starts_with(partial_segment)) {
+            ret.push_back(m_root);
+        }
+        return ret;
+    }
+
+    const Entry* owner_entry = find_entry(segments);
+    if (!owner_entry) {
+        return ret;
+    }
+
+    // children are ordered by name so every match is in one range starting at the partial segment
+    for (auto it = owner_entry->children.lower_bound(partial_segment); it != owner_entry->children.end(); it++) {
+        if (!std::string_view(it->first).starts_with(partial_segment)) {
+            break;
+        }
+        for (auto& child_id : it->second) {
+            if (ret.size() == limit) {
+                return ret;
+            }
+            ret.push_back(child_id);
+        }
+    }
+    return ret;
+}
+
+std::optional<std::string> QualifiedNameIndex::qualified_name(ID id) const {
+    if (m_root == ID::nullID()) {
+        return std::nullopt;
+    }
+    std::vector<const std::string*> names;
+    ID curr = id;
+    while (curr != m_root) {
+        auto match = m_entries.find(curr);
+        if (match == m_entries.end() || !match->second.indexed || match->second.owner == ID::nullID()) {
+            return std::nullopt;
+        }
+        names.push_back(&match->second.name);
+        curr = match->second.owner;
+    }
+    std::string ret = m_entries.at(m_root).name;
+    for (auto it = names.rbegin(); it != names.rend(); it++) {
+        ret += SEPARATOR;
+        ret += **it;
+    }
+    return ret;
+}
+
+}
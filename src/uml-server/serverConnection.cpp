@@ -0,0 +1,296 @@
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/types.h>
+#include <netdb.h>
+#include <cstring>
+#include <netinet/tcp.h>
+#include <unistd.h>
+#include "uml-server/serverConnection.h"
+#include "uml-server/umlServer.h"
+#include <charconv>
+#include <format>
+#include <map>
+#include <vector>
+
+using namespace EGM;
+
+namespace UML {
+
+// connections shared between clients to the same server, handed out round robin
+struct SharedConnections {
+    std::vector<std::weak_ptr<ServerConnection>> connections;
+    std::size_t next = 0;
+};
+static std::mutex shared_connections_mtx;
+static std::size_t shared_connections_per_server = 0;
+static std::map<std::pair<std::string, int>, SharedConnections> shared_connections;
+
+static std::mutex default_address_mtx;
+static std::string default_address_value;
+
+void ServerConnection::connect_tcp(std::string address, int port) {
+    struct addrinfo hints;
+    struct addrinfo* myAddress;
+    memset(&hints, 0, sizeof hints);
+    hints.ai_family = AF_UNSPEC;     // don't care IPv4 or IPv6
+    hints.ai_socktype = SOCK_STREAM; // TCP stream sockets
+    hints.ai_flags = address.empty() ? AI_PASSIVE : AI_CANONNAME; // fill in my IP for me
+    int status = 0;
+    if ((status = getaddrinfo(address.empty() ? 0 : address.c_str(), std::to_string(port).c_str(), &hints, &myAddress)) != 0) {
+        throw ManagerStateException("client could not get address! " + std::string(strerror(errno)));
+    }
+
+    // get socket descriptor
+    m_socketD = socket(myAddress->ai_family, myAddress->ai_socktype, myAddress->ai_protocol);
+    if (m_socketD == -1) {
+        freeaddrinfo(myAddress);
+        throw ManagerStateException("client could not get socket!");
+    }
+    if (connect(m_socketD, myAddress->ai_addr, myAddress->ai_addrlen) == -1) {
+        freeaddrinfo(myAddress);
+        close(m_socketD);
+        throw ManagerStateException("client could not connect to server! " + std::string(strerror(errno)));
+    }
+    freeaddrinfo(myAddress);
+
+    // disable Nagle's on client side for no latency, client tends to write write read which is bad and it is hard to bundle writes together
+    // since is controlled by user of api
+    int yes = 1;
+    int result = setsockopt(m_socketD, IPPROTO_TCP, TCP_NODELAY, (char*) &yes, sizeof(int));
+    if (result < 0) {
+        close(m_socketD);
+        throw ManagerStateException("could not disable Nagle's algorithm on client side!");
+    }
+}
+
+void ServerConnection::connect_unix(std::string path) {
+    struct sockaddr_un unix_address;
+    memset(&unix_address, 0, sizeof unix_address);
+    unix_address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof unix_address.sun_path) {
+        throw ManagerStateException("client socket path is too long! " + path);
+    }
+    strcpy(unix_address.sun_path, path.c_str());
+    m_socketD = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (m_socketD == -1) {
+        throw ManagerStateException("client could not get socket!");
+    }
+    if (connect(m_socketD, (struct sockaddr*) &unix_address, sizeof unix_address) == -1) {
+        close(m_socketD);
+        throw ManagerStateException("client could not connect to server at " + path + "! " + std::string(strerror(errno)));
+    }
+}
+
+void ServerConnection::handshake(bool unix_socket) {
+    // receive server identification (lists of meta_managers)
+    auto server_message = receive_message(m_socketD);
+    if (!server_message) {
+        throw ManagerStateException("could not process server initial message!");
+    }
+    m_server_info = std::move(*server_message);
+
+    std::string id_string = m_id.string();
+    send_message(m_socketD, id_string);
+
+    // server acknowledges by sending the id back
+    auto id_message = receive_message(m_socketD);
+    if (!id_message || id_message->size() != 28) {
+        throw ManagerStateException("wrong size for id sent to manager");
+    }
+    if (ID::fromString(*id_message) != m_id) {
+        throw ManagerStateException("wrong id from server!");
+    }
+
+    #ifdef __linux__
+    // the server is on this host, so have big replies mapped out of shared memory rather than copied through the socket
+    if (unix_socket) {
+        std::string shared_memory_request = "{\"shared_memory\":true}";
+        send_message(m_socketD, shared_memory_request);
+        auto shared_memory_reply = receive_message(m_socketD);
+        if (!shared_memory_reply) {
+            throw ManagerStateException("lost connection to server!");
+        }
+        m_shared_memory = shared_memory_reply->find("\"error\"") == std::string::npos;
+    }
+    #endif
+}
+
+ServerConnection::ServerConnection(std::string address, int port, ID id) : m_id(id) {
+    bool unix_socket = address.starts_with(UNIX_ADDRESS_PREFIX);
+    if (unix_socket) {
+        connect_unix(address.substr(UNIX_ADDRESS_PREFIX.size()));
+    } else {
+        connect_tcp(address, port);
+    }
+
+    // the socket is ours until the reader is running, so close it on any failed step of the handshake
+    try {
+        handshake(unix_socket);
+    } catch (...) {
+        close(m_socketD);
+        throw;
+    }
+
+    m_reader = std::thread(&ServerConnection::read_replies, this);
+}
+
+ServerConnection::~ServerConnection() {
+    // wake the reader up so it can be joined
+    shutdown(m_socketD, SHUT_RDWR);
+    if (m_reader.joinable()) {
+        m_reader.join();
+    }
+    close(m_socketD);
+}
+
+std::future<std::string> ServerConnection::request_async(std::string request, std::optional<ID> client) {
+    // tag the request so the reply can be matched to it whatever order replies come back in
+    std::promise<std::string> reply_promise;
+    std::future<std::string> ret = reply_promise.get_future();
+    std::unique_lock<std::mutex> pendingLck(m_pendingMtx);
+    if (m_connection_lost) {
+        throw ManagerStateException("lost connection to server!");
+    }
+    std::uint64_t request_id = m_next_request_id++;
+    if (client) {
+        request.insert(1, std::format("\"rid\":{},\"client\":\"{}\",", request_id, client->string()));
+    } else {
+        request.insert(1, std::format("\"rid\":{},", request_id));
+    }
+    m_pending_replies.emplace(request_id, std::move(reply_promise));
+    pendingLck.unlock();
+
+    // send outside of the pending lock so a big request doesn't hold the reader up from routing replies
+    try {
+        std::lock_guard<std::mutex> sendLck(m_sendMtx);
+        send_message(m_socketD, request);
+    } catch (...) {
+        std::lock_guard<std::mutex> relockPending(m_pendingMtx);
+        m_pending_replies.erase(request_id);
+        throw;
+    }
+    return ret;
+}
+
+void ServerConnection::route(ID client_id, PushedMessages& pushed) {
+    std::lock_guard<std::mutex> routesLck(m_routesMtx);
+    m_routes[client_id] = &pushed;
+}
+
+void ServerConnection::unroute(ID client_id) {
+    std::lock_guard<std::mutex> routesLck(m_routesMtx);
+    m_routes.erase(client_id);
+}
+
+void ServerConnection::push(ID client_id, std::string message) {
+    std::lock_guard<std::mutex> routesLck(m_routesMtx);
+    auto route_match = m_routes.find(client_id);
+    if (route_match == m_routes.end()) {
+        return;
+    }
+    PushedMessages& pushed = *route_match->second;
+    {
+        std::lock_guard<std::mutex> pushedLck(pushed.mtx);
+        pushed.messages.push_back(std::move(message));
+    }
+    pushed.cv.notify_all();
+}
+
+void ServerConnection::read_replies() {
+    static constexpr std::string_view REQUEST_ID_PREFIX = "{\"rid\":";
+    static constexpr std::string_view REPLY_PREFIX = ",\"reply\":";
+    static constexpr std::string_view TO_PREFIX = "{\"to\":\"";
+    static constexpr std::string_view MESSAGE_PREFIX = "\",\"message\":";
+    static constexpr std::size_t ID_LENGTH = 28;
+    while (true) {
+        #ifdef __linux__
+        auto message = m_shared_memory ? receive_any_message(m_socketD) : receive_message(m_socketD);
+        #else
+        auto message = receive_message(m_socketD);
+        #endif
+        if (!message) {
+            break;
+        }
+        if (message->starts_with(TO_PREFIX)) {
+            // pushed to one of the clients attached to the connection
+            std::size_t message_start = TO_PREFIX.size() + ID_LENGTH + MESSAGE_PREFIX.size();
+            if (message->size() > message_start && message->compare(TO_PREFIX.size() + ID_LENGTH, MESSAGE_PREFIX.size(), MESSAGE_PREFIX) == 0) {
+                push(ID::fromString(message->substr(TO_PREFIX.size(), ID_LENGTH)), message->substr(message_start, message->size() - message_start - 1));
+            }
+            continue;
+        }
+        if (!message->starts_with(REQUEST_ID_PREFIX)) {
+            push(m_id, std::move(*message));
+            continue;
+        }
+
+        // {"rid":n,"reply":reply}, take the reply out as is
+        std::uint64_t request_id = 0;
+        auto request_id_result = std::from_chars(message->data() + REQUEST_ID_PREFIX.size(), message->data() + message->size(), request_id);
+        std::size_t reply_start = request_id_result.ptr - message->data();
+        if (request_id_result.ec != std::errc() || message->compare(reply_start, REPLY_PREFIX.size(), REPLY_PREFIX) != 0) {
+            continue;
+        }
+        reply_start += REPLY_PREFIX.size();
+        std::lock_guard<std::mutex> pendingLck(m_pendingMtx);
+        auto pending_match = m_pending_replies.find(request_id);
+        if (pending_match == m_pending_replies.end()) {
+            continue;
+        }
+        pending_match->second.set_value(message->substr(reply_start, message->size() - reply_start - 1));
+        m_pending_replies.erase(pending_match);
+    }
+
+    // fail everything still waiting so no one waits forever
+    {
+        std::lock_guard<std::mutex> pendingLck(m_pendingMtx);
+        m_connection_lost = true;
+        for (auto& pending_pair : m_pending_replies) {
+            pending_pair.second.set_exception(std::make_exception_ptr(ManagerStateException("lost connection to server!")));
+        }
+        m_pending_replies.clear();
+    }
+    std::lock_guard<std::mutex> routesLck(m_routesMtx);
+    for (auto& route_pair : m_routes) {
+        {
+            std::lock_guard<std::mutex> pushedLck(route_pair.second->mtx);
+            route_pair.second->connection_lost = true;
+        }
+        route_pair.second->cv.notify_all();
+    }
+}
+
+void ServerConnection::share_connections(std::size_t num_connections) {
+    std::lock_guard<std::mutex> sharedLck(shared_connections_mtx);
+    // connections already handed out stay up until the clients using them are gone
+    shared_connections.clear();
+    shared_connections_per_server = num_connections;
+}
+
+void ServerConnection::set_default_address(std::string address) {
+    std::lock_guard<std::mutex> addressLck(default_address_mtx);
+    default_address_value = address;
+}
+
+std::string ServerConnection::default_address() {
+    std::lock_guard<std::mutex> addressLck(default_address_mtx);
+    return default_address_value;
+}
+
+std::shared_ptr<ServerConnection> ServerConnection::shared(std::string address, int port) {
+    std::lock_guard<std::mutex> sharedLck(shared_connections_mtx);
+    if (shared_connections_per_server == 0) {
+        return 0;
+    }
+    auto& server_connections = shared_connections[std::make_pair(address, port)];
+    server_connections.connections.resize(shared_connections_per_server);
+    auto& slot = server_connections.connections[server_connections.next++ % shared_connections_per_server];
+    auto ret = slot.lock();
+    if (!ret) {
+        ret = std::make_shared<ServerConnection>(address, port);
+        slot = ret;
+    }
+    return ret;
+}
+
+}
@@ -1,9 +1,4 @@
-#include <sys/socket.h>
-#include <sys/types.h>
-#include <netdb.h>
 #include <cstring>
-#include <netinet/tcp.h>
-#include <unistd.h>
 #include "uml-server/serverPersistencePolicy.h"
 #include "uml/uml-stable.h"
 #include "yaml-cpp/yaml.h"
@@ -11,6 +6,13 @@
 #include "uml-server/umlServer.h"
 #include <future>
 #include <format>
+#include <optional>
+#include <unordered_set>
+#include <charconv>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
 
 using namespace std;
 using namespace EGM;
@@ -23,30 +25,256 @@ void ServerPersistencePolicy::create_storage(AbstractElement& el) {
                 element_types_to_name.at(el.getElementType()),
                 el.getID().string()
             );
-    send_message(m_socketD, post_request);
-    receive_and_check_reply();
+    if (m_async_acks) {
+        m_async_acks->push_back(request_async(post_request));
+        return;
+    }
+    check_reply(request(post_request));
+}
+
+std::future<std::string> ServerPersistencePolicy::request_async(std::string request) {
+    if (m_attached) {
+        return m_connection->request_async(std::move(request), clientID);
+    }
+    return m_connection->request_async(std::move(request));
+}
+
+std::string ServerPersistencePolicy::request(std::string request) {
+    return request_async(std::move(request)).get();
+}
+
+std::string ServerPersistencePolicy::request(YAML::Emitter& emitter) {
+    return request(std::string(emitter.c_str()));
 }
 
+// reply to a get with a version parameter, {"id":id,"version":n} with ,"element":emit before the
+// closing brace if the version asked for is out of date
+struct VersionedReply {
+    ID id;
+    std::uint64_t version = 0;
+    std::optional<std::string> element;
+};
+
+static VersionedReply parse_versioned_reply(std::string& reply) {
+    static constexpr std::string_view ID_PREFIX = "{\"id\":\"";
+    static constexpr std::string_view VERSION_PREFIX = "\",\"version\":";
+    static constexpr std::string_view ELEMENT_PREFIX = ",\"element\":";
+    static constexpr std::size_t ID_LENGTH = 28;
+
+    // the element is spliced in by the server, so take it out as is instead of parsing and emitting it again
+    std::size_t version_start = ID_PREFIX.size() + ID_LENGTH + VERSION_PREFIX.size();
+    if (!reply.starts_with(ID_PREFIX) || reply.size() <= version_start || reply.compare(ID_PREFIX.size() + ID_LENGTH, VERSION_PREFIX.size(), VERSION_PREFIX) != 0) {
+        YAML::Node reply_node = YAML::Load(reply);
+        for (std::string error_key : {"error", "ERROR"}) {
+            if (reply_node[error_key]) {
+                throw ManagerStateException("received error from server: " + reply_node[error_key].as<std::string>());
+            }
+        }
+        throw ManagerStateException("improper reply from server to versioned get!");
+    }
 
-void ServerPersistencePolicy::sendEmitter(int socket, YAML::Emitter& emitter) {
-    string emitter_string(emitter.c_str());
-    send_message(socket, emitter_string);
+    VersionedReply ret;
+    ret.id = ID::fromString(reply.substr(ID_PREFIX.size(), ID_LENGTH));
+    auto version_result = std::from_chars(reply.data() + version_start, reply.data() + reply.size(), ret.version);
+    std::size_t version_end = version_result.ptr - reply.data();
+    if (version_result.ec != std::errc() || version_end == reply.size()) {
+        throw ManagerStateException("improper version in reply from server to versioned get!");
+    }
+    if (reply.compare(version_end, ELEMENT_PREFIX.size(), ELEMENT_PREFIX) == 0) {
+        std::size_t element_start = version_end + ELEMENT_PREFIX.size();
+        ret.element = reply.substr(element_start, reply.size() - element_start - 1);
+    }
+    return ret;
 }
 
 std::string ServerPersistencePolicy::loadElementData(ID id) {
-    // request
+    if (!m_cache.empty() || !m_disk_cache.empty()) {
+        drain_pushed();
+        auto cache_match = m_cache_entries.find(id);
+        if (cache_match != m_cache_entries.end()) {
+            m_cache.erase(cache_match->second);
+            m_cache_entries.erase(cache_match);
+            return m_last_sent.at(id).body;
+        }
+        auto disk_match = m_disk_cache.find(id);
+        if (disk_match != m_disk_cache.end()) {
+            std::ifstream body_file(std::filesystem::path(m_disk_cache_path) / (id.string() + ".json"));
+            std::stringstream body_stream;
+            body_stream << body_file.rdbuf();
+            std::uint64_t version = disk_match->second;
+            m_disk_cache.erase(disk_match);
+            if (body_file) {
+                m_last_sent[id] = SentElement { body_stream.str(), version };
+                return m_last_sent[id].body;
+            }
+        }
+    }
+
+    std::string data = accept_element(id, request(get_request(id)));
+    flush_uncached();
+    return data;
+}
+
+std::string ServerPersistencePolicy::get_request(ID id) const {
+    std::string get_parameters = id.string();
+    if (caching()) {
+        // versioned so the server tracks what we cache
+        get_parameters += "?version=0";
+    }
+    YAML::Emitter emitter;
+    emitter << YAML::DoubleQuoted  << YAML::Flow << YAML::BeginMap << 
+        YAML::Key << "GET" << YAML::Value << get_parameters << 
+    YAML::EndMap;
+    return emitter.c_str();
+}
+
+std::string ServerPersistencePolicy::accept_element(ID id, std::string reply) {
+    if (!caching()) {
+        m_last_sent[id] = SentElement { reply, 0 };
+        return reply;
+    }
+    auto versioned_reply = parse_versioned_reply(reply);
+    if (!versioned_reply.element) {
+        throw ManagerStateException("server did not send element " + id.string());
+    }
+    m_last_sent[id] = SentElement { *versioned_reply.element, versioned_reply.version };
+    return *versioned_reply.element;
+}
+
+void ServerPersistencePolicy::wait_for_acks(std::vector<std::future<std::string>>& acks) {
+    for (auto& ack : acks) {
+        check_reply(ack.get());
+    }
+}
+
+ID ServerPersistencePolicy::resolve_qualified_name(std::string qualified_name) {
+    // send the version of what the name resolved to last time so the body only comes back if it changed
+    std::uint64_t known_version = 0;
+    std::optional<ID> known_id;
+    auto known_match = m_qualified_name_ids.find(qualified_name);
+    if (known_match != m_qualified_name_ids.end()) {
+        known_id = known_match->second;
+        drain_pushed();
+        auto last_sent_match = m_last_sent.find(*known_id);
+        if (last_sent_match != m_last_sent.end()) {
+            known_version = last_sent_match->second.version;
+        }
+    }
+
     YAML::Emitter emitter;
     emitter << YAML::DoubleQuoted  << YAML::Flow << YAML::BeginMap << 
-        YAML::Key << "GET" << YAML::Value << id.string() << 
+        YAML::Key << "GET" << YAML::Value << qualified_name + "?version=" + std::to_string(known_version) << 
     YAML::EndMap;
-    sendEmitter(m_socketD, emitter);
+    std::string data = request(emitter);
+    auto versioned_reply = parse_versioned_reply(data);
+    m_qualified_name_ids[qualified_name] = versioned_reply.id;
+    if (versioned_reply.element) {
+        m_last_sent[versioned_reply.id] = SentElement { std::move(*versioned_reply.element), versioned_reply.version };
+        cache_element(versioned_reply.id);
+    } else if (known_id != versioned_reply.id) {
+        // the version matched but of what the name resolved to before, get it by id
+        invalidate(versioned_reply.id);
+    }
+    return versioned_reply.id;
+}
+
+void ServerPersistencePolicy::cache_element(ID id) const {
+    auto cache_match = m_cache_entries.find(id);
+    if (cache_match != m_cache_entries.end()) {
+        m_cache.erase(cache_match->second);
+    }
+    m_cache.push_front(id);
+    m_cache_entries[id] = m_cache.begin();
+    while (m_cache.size() > std::max<std::size_t>(m_cache_size, 1)) {
+        ID evicted_id = m_cache.back();
+        m_cache.pop_back();
+        m_cache_entries.erase(evicted_id);
+        forget_sent(evicted_id);
+    }
+}
+
+void ServerPersistencePolicy::retire_sent(ID id) const {
+    if (m_cache_size) {
+        cache_element(id);
+        return;
+    }
+
+    // nothing is cached in memory, so the body is only kept on disk if there is a disk cache
+    auto sent_match = m_last_sent.find(id);
+    if (sent_match == m_last_sent.end()) {
+        return;
+    }
+    if (!m_disk_cache_path.empty() && sent_match->second.version) {
+        std::ofstream body_file(std::filesystem::path(m_disk_cache_path) / (id.string() + ".json"), std::ios::trunc);
+        body_file << sent_match->second.body;
+        if (body_file) {
+            m_disk_cache[id] = sent_match->second.version;
+        }
+    }
+    forget_sent(id);
+}
+
+void ServerPersistencePolicy::forget_sent(ID id) const {
+    m_last_sent.erase(id);
+    if (caching() && !m_disk_cache.contains(id)) {
+        m_uncached.insert(id);
+    }
+}
+
+void ServerPersistencePolicy::flush_uncached() {
+    if (m_uncached.size() < UML_CLIENT_UNCACHE_BATCH) {
+        return;
+    }
+
+    // {"uncache":[ids]}, an id gotten again since it was forgotten is tracked by the server again so it stays
+    YAML::Emitter emitter;
+    emitter << YAML::DoubleQuoted << YAML::Flow << YAML::BeginMap << YAML::Key << "uncache" << YAML::Value << YAML::BeginSeq;
+    for (auto& uncached_id : m_uncached) {
+        if (!m_last_sent.contains(uncached_id) && !m_disk_cache.contains(uncached_id)) {
+            emitter << uncached_id.string();
+        }
+    }
+    emitter << YAML::EndSeq << YAML::EndMap;
+    m_uncached.clear();
+    // nothing waits on the reply, requests are handled in order so a later get is tracked again
+    request_async(emitter.c_str());
+}
+
+void ServerPersistencePolicy::invalidate(ID id) const {
+    m_disk_cache.erase(id);
+    auto cache_match = m_cache_entries.find(id);
+    if (cache_match == m_cache_entries.end()) {
+        return;
+    }
+    m_cache.erase(cache_match->second);
+    m_cache_entries.erase(cache_match);
+    m_last_sent.erase(id);
+}
+
+bool ServerPersistencePolicy::handle_pushed(std::string& message) const {
+    if (message.starts_with("{\"notification\"")) {
+        m_notifications.push_back(message);
+        return true;
+    }
+    if (message.starts_with("{\"invalidate\"")) {
+        invalidate(ID::fromString(YAML::Load(message)["invalidate"].as<std::string>()));
+        return true;
+    }
+    return false;
+}
 
-    // receive
-    return *receive_message(m_socketD);
+void ServerPersistencePolicy::drain_pushed() const {
+    std::list<std::string> pushed;
+    {
+        std::lock_guard<std::mutex> pushedLck(m_pushed.mtx);
+        pushed.swap(m_pushed.messages);
+    }
+    for (auto& message : pushed) {
+        handle_pushed(message);
+    }
 }
 
-void ServerPersistencePolicy::receive_and_check_reply() const {
-    auto reply = *receive_message(m_socketD);
+std::string ServerPersistencePolicy::check_reply(std::string reply) {
     YAML::Node reply_json = YAML::Load(reply);
     if (reply_json["error"]) {
         throw ManagerStateException(std::format("received error from server: {}", reply_json["error"].as<std::string>()));
@@ -57,16 +285,174 @@ void ServerPersistencePolicy::receive_and_check_reply() const {
     if (reply_json["status"].as<std::string>() != "success") {
         throw ManagerStateException("status from server is not success!");
     }
+    return reply;
+}
+
+// make_patch
+// previous - emit of the element the server has
+// current - emit of the element now
+// return - the body of a patch request turning previous into current, nullopt if only a put can do it
+static std::optional<std::string> make_patch(ID id, YAML::Node previous, YAML::Node current) {
+    // only the body of the element is patched, anything else changing (e.g. the owner) needs a put
+    if (!previous.IsMap() || !current.IsMap() || previous.size() != current.size()) {
+        return std::nullopt;
+    }
+    YAML::Node previous_body;
+    YAML::Node current_body;
+    for (auto current_pair : current) {
+        std::string key = current_pair.first.as<std::string>();
+        auto previous_value = previous[key];
+        if (!previous_value) {
+            return std::nullopt;
+        }
+        if (current_pair.second.IsMap()) {
+            previous_body = previous_value;
+            current_body = current_pair.second;
+        } else if (YAML::Dump(previous_value) != YAML::Dump(current_pair.second)) {
+            return std::nullopt;
+        }
+    }
+    if (!previous_body || !current_body || !previous_body.IsMap()) {
+        return std::nullopt;
+    }
+
+    YAML::Emitter set_emitter;
+    YAML::Emitter add_emitter;
+    YAML::Emitter remove_emitter;
+    std::vector<std::string> unset;
+    bool has_set = false;
+    bool has_add = false;
+    bool has_remove = false;
+    for (auto* emitter : {&set_emitter, &add_emitter, &remove_emitter}) {
+        *emitter << YAML::DoubleQuoted << YAML::Flow << YAML::BeginMap;
+    }
+    for (auto current_pair : current_body) {
+        std::string key = current_pair.first.as<std::string>();
+        auto previous_value = previous_body[key];
+        if (previous_value && current_pair.second.IsSequence() && previous_value.IsSequence()) {
+            // diff set contents so big sets only send their changes
+            std::unordered_set<std::string> previous_ids;
+            std::unordered_set<std::string> current_ids;
+            for (auto value_node : previous_value) {
+                previous_ids.insert(value_node.as<std::string>());
+            }
+            for (auto value_node : current_pair.second) {
+                current_ids.insert(value_node.as<std::string>());
+            }
+            std::vector<std::string> added;
+            std::vector<std::string> removed;
+            for (auto value_node : current_pair.second) {
+                if (!previous_ids.contains(value_node.as<std::string>())) {
+                    added.push_back(value_node.as<std::string>());
+                }
+            }
+            for (auto value_node : previous_value) {
+                if (!current_ids.contains(value_node.as<std::string>())) {
+                    removed.push_back(value_node.as<std::string>());
+                }
+            }
+            // add and remove keep what was there in place and append what is new, so anything else (a reorder of
+            // an ordered set, an insert before the end) has to send the whole sequence
+            std::vector<std::string> patched;
+            for (auto value_node : previous_value) {
+                if (current_ids.contains(value_node.as<std::string>())) {
+                    patched.push_back(value_node.as<std::string>());
+                }
+            }
+            patched.insert(patched.end(), added.begin(), added.end());
+            bool in_order = patched.size() == current_pair.second.size();
+            for (std::size_t i = 0; in_order && i < patched.size(); i++) {
+                in_order = patched[i] == current_pair.second[i].as<std::string>();
+            }
+            if (!in_order) {
+                set_emitter << YAML::Key << key << YAML::Value << current_pair.second;
+                has_set = true;
+                continue;
+            }
+            if (!added.empty()) {
+                add_emitter << YAML::Key << key << YAML::Value << added;
+                has_add = true;
+            }
+            if (!removed.empty()) {
+                remove_emitter << YAML::Key << key << YAML::Value << removed;
+                has_remove = true;
+            }
+            continue;
+        }
+        if (!previous_value || YAML::Dump(previous_value) != YAML::Dump(current_pair.second)) {
+            set_emitter << YAML::Key << key << YAML::Value << current_pair.second;
+            has_set = true;
+        }
+    }
+    for (auto previous_pair : previous_body) {
+        std::string key = previous_pair.first.as<std::string>();
+        if (!current_body[key]) {
+            unset.push_back(key);
+        }
+    }
+    for (auto* emitter : {&set_emitter, &add_emitter, &remove_emitter}) {
+        *emitter << YAML::EndMap;
+    }
+
+    std::string patch = std::format("{{\"id\":\"{}\"", id.string());
+    if (has_set) {
+        patch += std::string(",\"set\":") + set_emitter.c_str();
+    }
+    if (!unset.empty()) {
+        YAML::Emitter unset_emitter;
+        unset_emitter << YAML::DoubleQuoted << YAML::Flow << unset;
+        patch += std::string(",\"unset\":") + unset_emitter.c_str();
+    }
+    if (has_add) {
+        patch += std::string(",\"add\":") + add_emitter.c_str();
+    }
+    if (has_remove) {
+        patch += std::string(",\"remove\":") + remove_emitter.c_str();
+    }
+    patch += "}";
+    return patch;
+}
+
+// return - version the server gave the element in the reply to a put or patch, 0 if it sent none
+static std::uint64_t reply_version(std::string reply) {
+    YAML::Node version_node = YAML::Load(reply)["version"];
+    return version_node ? version_node.as<std::uint64_t>() : 0;
 }
 
 void ServerPersistencePolicy::saveElementData(std::string data, ID id) {
-    YAML::Emitter emitter;
-    emitter << YAML::DoubleQuoted << YAML::Flow << YAML::BeginMap << 
-        YAML::Key << "PUT" << YAML::Value << YAML::BeginMap << YAML::Key << 
-        "id" << YAML::Value << id.string() << YAML::Key << "element" << YAML::Value << 
-        YAML::Load(data) << YAML::EndMap << YAML::EndMap;
-    sendEmitter(m_socketD, emitter);
-    receive_and_check_reply();
+    auto last_sent_match = m_last_sent.find(id);
+    if (last_sent_match != m_last_sent.end()) {
+        if (last_sent_match->second.body == data) {
+            // nothing changed since the server last saw it
+            retire_sent(id);
+            return;
+        }
+        auto patch = make_patch(id, YAML::Load(last_sent_match->second.body), YAML::Load(data));
+        if (patch && patch->size() < data.size()) {
+            std::string patch_request = "{\"PATCH\":" + *patch + "}";
+            if (m_async_acks) {
+                // the version is not known until the reply comes, so this body is not kept on disk
+                m_async_acks->push_back(request_async(patch_request));
+                last_sent_match->second.version = 0;
+            } else {
+                last_sent_match->second.version = reply_version(check_reply(request(patch_request)));
+            }
+            last_sent_match->second.body = std::move(data);
+            retire_sent(id);
+            return;
+        }
+    }
+
+    // the emit is already json, splice it in instead of parsing it into an emitter
+    std::string put_request = std::format("{{\"PUT\":{{\"id\":\"{}\",\"element\":{}}}}}", id.string(), data);
+    if (m_async_acks) {
+        m_async_acks->push_back(request_async(put_request));
+        m_last_sent[id] = SentElement { std::move(data), 0 };
+    } else {
+        m_last_sent[id] = SentElement { std::move(data), reply_version(check_reply(request(put_request))) };
+    }
+    retire_sent(id);
+    flush_uncached();
 }
 
 std::string ServerPersistencePolicy::getProjectData(std::string path) {
@@ -83,24 +469,27 @@ void ServerPersistencePolicy::saveProjectData(std::string data, std::string path
     // TODO this one is weird, maybe we connect to a different server ?
     YAML::Emitter emitter;
     emitter << YAML::DoubleQuoted << YAML::Flow << YAML::BeginMap << YAML::Key << "save" << YAML::Value << "." << YAML::EndMap;
-    sendEmitter(m_socketD, emitter);
-    receive_and_check_reply();
+    check_reply(request(emitter));
 }
 
 void ServerPersistencePolicy::saveProjectData(std::string data) {
     YAML::Emitter emitter;
     emitter << YAML::DoubleQuoted << YAML::Flow << YAML::BeginMap << YAML::Key << "save" << YAML::Value << "." << YAML::EndMap;
-    sendEmitter(m_socketD, emitter);
-    receive_and_check_reply();
+    check_reply(request(emitter));
 }
 
 void ServerPersistencePolicy::eraseEl(ID id) {
+    invalidate(id);
+    m_last_sent.erase(id);
     YAML::Emitter emitter;
     emitter << YAML::DoubleQuoted  << YAML::Flow << YAML::BeginMap << 
         YAML::Key << "DELETE" << YAML::Value << id.string() << 
     YAML::EndMap;
-    sendEmitter(m_socketD, emitter);
-    receive_and_check_reply();
+    if (m_async_acks) {
+        m_async_acks->push_back(request_async(emitter.c_str()));
+        return;
+    }
+    check_reply(request(emitter));
 }
 
 AbstractElementPtr ServerPersistencePolicy::reindex(ID oldID, ID newID) {
@@ -109,58 +498,21 @@ AbstractElementPtr ServerPersistencePolicy::reindex(ID oldID, ID newID) {
 }
 
 ServerPersistencePolicy::ServerPersistencePolicy() {
-    struct addrinfo hints;
-    struct addrinfo* myAddress;
-    memset(&hints, 0, sizeof hints);
-    hints.ai_family = AF_UNSPEC;     // don't care IPv4 or IPv6
-    hints.ai_socktype = SOCK_STREAM; // TCP stream sockets
-    hints.ai_flags = m_address.empty() ? AI_PASSIVE : AI_CANONNAME; // fill in my IP for me
-    int status = 0;
-    if ((status = getaddrinfo(m_address.empty() ? 0 : m_address.c_str(), std::to_string(m_port).c_str(), &hints, &myAddress)) != 0) {
-        throw ManagerStateException("client could not get address! " + std::string(strerror(errno)));
-    }
-
-    // get socket descriptor
-    m_socketD = socket(myAddress->ai_family, myAddress->ai_socktype, myAddress->ai_protocol);
-    if (m_socketD == -1) {
-        freeaddrinfo(myAddress);
-        throw ManagerStateException("client could not get socket!");
-    }
-    if (connect(m_socketD, myAddress->ai_addr, myAddress->ai_addrlen) == -1) {
-        freeaddrinfo(myAddress);
-        throw ManagerStateException("client could not connect to server! " + std::string(strerror(errno)));
-    }
-    freeaddrinfo(myAddress);
-    
-    // disable Nagle's on client side for no latency, client tends to write write read which is bad and it is hard to bundle writes together 
-    // since is controlled by user of api
-    int yes = 1;
-    int result = setsockopt(m_socketD, IPPROTO_TCP, TCP_NODELAY, (char*) &yes, sizeof(int));
-    if (result < 0) {
-        throw ManagerStateException("could not disable Nagle's algorithm on client side!");
-    }
-
-    // receive server identification (lists of meta_managers)
-    uint64_t server_message_size;
-    int bytes_received = recv(m_socketD, &server_message_size, sizeof(uint64_t), 0);
-    if (bytes_received != sizeof(uint64_t)) {
-        throw ManagerStateException();
+    // server identification (list of meta_managers)
+    YAML::Node server_message_node;
+    m_connection = ServerConnection::shared(m_address, m_port);
+    if (m_connection) {
+        // attach to the shared connection, the reply lists the meta managers like the handshake does
+        m_connection->route(clientID, m_pushed);
+        std::string attach_request = std::format("{{\"attach\":\"{}\"}}", clientID.string());
+        YAML::Node reply_node = YAML::Load(check_reply(m_connection->request_async(attach_request).get()));
+        server_message_node = reply_node["meta_managers"];
+        m_attached = true;
+    } else {
+        m_connection = std::make_shared<ServerConnection>(m_address, m_port, clientID);
+        m_connection->route(clientID, m_pushed);
+        server_message_node = YAML::Load(m_connection->server_info());
     }
-
-    server_message_size = be64toh(server_message_size);
-    char* server_message_buffer = (char*) malloc((server_message_size + 1) * sizeof(char));
-    char* buffer_index = server_message_buffer;
-    while ((bytes_received = recv(m_socketD, buffer_index, server_message_size, 0)) < (int) server_message_size) {
-        if (bytes_received <= 0) {
-            throw ManagerStateException("could not process server initial message!");
-        }
-        server_message_size -= bytes_received;
-        buffer_index += bytes_received;
-    }
-
-    server_message_buffer[server_message_size] = '\0';
-
-    auto server_message_node = YAML::Load(server_message_buffer);
     
     m_initialization_procedure = [server_message_node, this](){
         for (auto manager_info_node : server_message_node) {
@@ -170,33 +522,187 @@ ServerPersistencePolicy::ServerPersistencePolicy() {
             );
         }             
     };
-    
-    free(server_message_buffer);
-    std::string id_string = clientID.string();
-    send_message(m_socketD, id_string);
+}
 
-    // receive
-    uint64_t receive_message_size;
-    bytes_received = recv(m_socketD, &receive_message_size, sizeof(uint64_t), 0);
-    if (bytes_received != sizeof(uint64_t)) {
-        throw ManagerStateException("could not process entire size");
+void ServerPersistencePolicy::send_subscription(std::string request_name, std::string scope, std::string value, bool bodies) {
+    YAML::Emitter emitter;
+    emitter << YAML::DoubleQuoted << YAML::Flow << YAML::BeginMap << 
+        YAML::Key << request_name << YAML::Value << YAML::BeginMap << 
+            YAML::Key << scope << YAML::Value << value;
+    if (bodies) {
+        emitter << YAML::Key << "body" << YAML::Value << true;
     }
+    emitter << YAML::EndMap << YAML::EndMap;
+    check_reply(request(emitter));
+}
+
+void ServerPersistencePolicy::subscribe(ID id, SubscriptionScope scope, bool bodies) {
+    send_subscription("subscribe", scope == SubscriptionScope::ELEMENT ? "element" : "subtree", id.string(), bodies);
+}
+
+void ServerPersistencePolicy::subscribe(std::string type_name, bool bodies) {
+    send_subscription("subscribe", "type", type_name, bodies);
+}
 
-    receive_message_size = be64toh(receive_message_size);
-    if (receive_message_size != 28)
-        throw ManagerStateException("wrong size for id sent to manager");
+void ServerPersistencePolicy::unsubscribe(ID id, SubscriptionScope scope) {
+    send_subscription("unsubscribe", scope == SubscriptionScope::ELEMENT ? "element" : "subtree", id.string(), false);
+}
+
+void ServerPersistencePolicy::unsubscribe(std::string type_name) {
+    send_subscription("unsubscribe", "type", type_name, false);
+}
 
-    char id_buffer[29];
-    char* id_index = id_buffer;
-    while ((bytes_received = recv(m_socketD, id_index, receive_message_size, 0)) < (int) receive_message_size) {
-        receive_message_size -= bytes_received;
-        id_index += bytes_received;
+std::optional<ChangeNotification> ServerPersistencePolicy::next_notification(int timeout_ms) {
+    drain_pushed();
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+    while (m_notifications.empty()) {
+        {
+            std::unique_lock<std::mutex> pushedLck(m_pushed.mtx);
+            if (!m_pushed.cv.wait_until(pushedLck, deadline, [this] { return !m_pushed.messages.empty() || m_pushed.connection_lost; })) {
+                return std::nullopt;
+            }
+            if (m_pushed.messages.empty()) {
+                throw ManagerStateException("lost connection to server!");
+            }
+        }
+        drain_pushed();
     }
-    id_buffer[28] = '\0';
 
-    ID id_from_server = ID::fromString(id_buffer);
-    if (id_from_server != clientID) {
-        throw ManagerStateException("wrong id from server!");
+    YAML::Node notification_node = YAML::Load(m_notifications.front())["notification"];
+    m_notifications.pop_front();
+    ChangeNotification notification;
+    notification.kind = notification_node["kind"].as<std::string>();
+    notification.id = ID::fromString(notification_node["id"].as<std::string>());
+    notification.type = notification_node["type"].as<std::string>();
+    if (notification_node["body"]) {
+        YAML::Emitter body_emitter;
+        body_emitter << YAML::DoubleQuoted << YAML::Flow << notification_node["body"];
+        notification.body = body_emitter.c_str();
+    }
+    return notification;
+}
+
+void ServerPersistencePolicy::set_cache_size(std::size_t size) {
+    if (!size && m_cache_size) {
+        // keep last sent bodies only for elements that are loaded
+        for (auto& cached_id : m_cache) {
+            m_last_sent.erase(cached_id);
+        }
+        m_cache.clear();
+        m_cache_entries.clear();
+    }
+    if (static_cast<bool>(size) != static_cast<bool>(m_cache_size) && m_disk_cache_path.empty()) {
+        send_subscription(size ? "subscribe" : "unsubscribe", "cache", "true", false);
+    }
+    m_cache_size = size;
+    while (m_cache.size() > m_cache_size) {
+        ID evicted_id = m_cache.back();
+        m_cache.pop_back();
+        m_cache_entries.erase(evicted_id);
+        forget_sent(evicted_id);
+    }
+    if (!caching()) {
+        // the server stopped tracking everything along with the subscription
+        m_uncached.clear();
+    }
+    flush_uncached();
+}
+
+bool ServerPersistencePolicy::cached(ID id) const {
+    drain_pushed();
+    return m_cache_entries.contains(id) || m_disk_cache.contains(id);
+}
+
+void ServerPersistencePolicy::open_disk_cache(std::string path) {
+    std::filesystem::path directory(path);
+    std::filesystem::create_directories(directory);
+    if (!caching()) {
+        send_subscription("subscribe", "cache", "true", false);
+    }
+    m_disk_cache_path = path;
+
+    YAML::Node index_node;
+    if (std::filesystem::exists(directory / "index.yml")) {
+        index_node = YAML::LoadFile((directory / "index.yml").string());
+    }
+
+    // check everything on disk in one request
+    YAML::Emitter emitter;
+    emitter << YAML::DoubleQuoted << YAML::Flow << YAML::BeginMap << 
+        YAML::Key << "validate" << YAML::Value << YAML::BeginMap << 
+            YAML::Key << "epoch" << YAML::Value << (index_node["epoch"] ? index_node["epoch"].as<std::string>() : "") << 
+            YAML::Key << "elements" << YAML::Value << YAML::BeginMap;
+    for (auto element_pair : index_node["elements"]) {
+        emitter << YAML::Key << element_pair.first.as<std::string>() << YAML::Value << element_pair.second.as<std::uint64_t>();
+    }
+    emitter << YAML::EndMap << YAML::EndMap << YAML::EndMap;
+    YAML::Node reply_node = YAML::Load(request(emitter));
+    if (reply_node["error"]) {
+        throw ManagerStateException("received error from server: " + reply_node["error"].as<std::string>());
+    }
+    m_server_epoch = reply_node["epoch"].as<std::string>();
+    std::unordered_set<std::string> stale;
+    for (auto stale_node : reply_node["stale"]) {
+        stale.insert(stale_node.as<std::string>());
+    }
+    for (auto element_pair : index_node["elements"]) {
+        std::string element_id = element_pair.first.as<std::string>();
+        if (stale.contains(element_id)) {
+            std::filesystem::remove(directory / (element_id + ".json"));
+            continue;
+        }
+        ID cached_id = ID::fromString(element_id);
+        m_disk_versions[cached_id] = element_pair.second.as<std::uint64_t>();
+        m_disk_cache[cached_id] = m_disk_versions[cached_id];
+    }
+}
+
+void ServerPersistencePolicy::write_disk_cache() {
+    std::filesystem::path directory(m_disk_cache_path);
+    YAML::Emitter index_emitter;
+    index_emitter << YAML::BeginMap << 
+        YAML::Key << "epoch" << YAML::Value << m_server_epoch << 
+        YAML::Key << "elements" << YAML::Value << YAML::BeginMap;
+    std::unordered_set<ID> indexed;
+    for (auto& sent_pair : m_last_sent) {
+        // without a version we can not tell if it is up to date when we come back
+        if (!sent_pair.second.version) {
+            continue;
+        }
+        auto disk_version_match = m_disk_versions.find(sent_pair.first);
+        if (disk_version_match == m_disk_versions.end() || disk_version_match->second != sent_pair.second.version) {
+            std::ofstream body_file(directory / (sent_pair.first.string() + ".json"), std::ios::trunc);
+            body_file << sent_pair.second.body;
+            if (!body_file) {
+                continue;
+            }
+        }
+        index_emitter << YAML::Key << sent_pair.first.string() << YAML::Value << sent_pair.second.version;
+        indexed.insert(sent_pair.first);
+    }
+    for (auto& disk_pair : m_disk_cache) {
+        if (indexed.insert(disk_pair.first).second) {
+            index_emitter << YAML::Key << disk_pair.first.string() << YAML::Value << disk_pair.second;
+        }
+    }
+    index_emitter << YAML::EndMap << YAML::EndMap;
+
+    // replace the index in one step so a crash never leaves it pointing at half written bodies
+    {
+        std::ofstream index_file(directory / "index.yml.tmp", std::ios::trunc);
+        index_file << index_emitter.c_str();
+    }
+    std::filesystem::rename(directory / "index.yml.tmp", directory / "index.yml");
+
+    // drop bodies nothing points to anymore
+    for (auto& entry : std::filesystem::directory_iterator(directory)) {
+        if (entry.path().extension() != ".json") {
+            continue;
+        }
+        std::string stem = entry.path().stem().string();
+        if (!ID::isValid(stem) || !indexed.contains(ID::fromString(stem))) {
+            std::filesystem::remove(entry.path());
+        }
     }
 }
 
@@ -205,7 +711,23 @@ void mount(string mountPath) {
 }
 
 ServerPersistencePolicy::~ServerPersistencePolicy() {
-    close(m_socketD);
+    if (!m_disk_cache_path.empty()) {
+        try {
+            write_disk_cache();
+        } catch (std::exception&) {
+            // losing the cache only costs a cold start next time
+        }
+    }
+
+    if (m_attached) {
+        try {
+            std::string detach_request = std::format("{{\"detach\":\"{}\"}}", clientID.string());
+            m_connection->request_async(detach_request).get();
+        } catch (std::exception&) {
+            // the connection is gone, and us along with it
+        }
+    }
+    m_connection->unroute(clientID);
 }
 
 }
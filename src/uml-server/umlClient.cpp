@@ -12,22 +12,39 @@ using namespace EGM;
 namespace UML {
 
 UmlClient::Pointer<Element> UmlClient::get(std::string qualifiedName) {
-    // TODO check if one is in memory?
-    
+    // the element is only sent if we do not have it already, then it is gotten from memory or the cache
+    return BaseManager::get(resolve_qualified_name(qualifiedName));
+}
+
+UmlClient::Pointer<Element> UmlClient::get(ID id, std::size_t depth) {
     // request
     YAML::Emitter emitter;
     emitter << YAML::DoubleQuoted  << YAML::Flow << YAML::BeginMap << 
-        YAML::Key << "GET" << YAML::Value << qualifiedName << 
+        YAML::Key << "GET" << YAML::Value << id.string() + "?depth=" + std::to_string(depth) << 
     YAML::EndMap;
-    sendEmitter(m_socketD, emitter);
-
-    // receive and parse
-    UmlClient::Pointer<Element> ret = JsonSerializationPolicy<UmlTypes>::parseIndividual(*receive_message(m_socketD));
-    
-    // Todo run restoration
 
+    // receive and parse every element we do not have yet
+    YAML::Node reply = YAML::Load(request(emitter));
+    if (!reply.IsSequence()) {
+        if (reply["error"]) {
+            throw ManagerStateException("received error from server: " + reply["error"].as<std::string>());
+        }
+        throw ManagerStateException("subtree get reply must be a sequence!");
+    }
+    for (auto element_node : reply) {
+        if (!element_node.IsMap() || element_node.begin() == element_node.end()) {
+            continue;
+        }
+        auto element_id_node = element_node.begin()->second["id"];
+        if (element_id_node && this->loaded(ID::fromString(element_id_node.as<std::string>()))) {
+            continue;
+        }
+        YAML::Emitter element_emitter;
+        element_emitter << YAML::DoubleQuoted << YAML::Flow << element_node;
+        JsonSerializationPolicy<UmlTypes>::parseIndividual(element_emitter.c_str());
+    }
 
-    return ret;
+    return BaseManager::get(id);
 }
 
 void UmlClient::setRoot(AbstractElementPtr root) {
@@ -40,8 +57,24 @@ void UmlClient::setRoot(AbstractElementPtr root) {
         YAML::Key << "PUT" << YAML::Value << YAML::BeginMap << YAML::Key << 
         "id" << YAML::Value << root->getID().string() << YAML::Key << "qualifiedName" << YAML::Value << "" << 
         YAML::Key << "element" << YAML::Value << YAML::Load(emitIndividual(dynamic_cast<UmlClient::BaseElement&>(*root))) << YAML::EndMap << YAML::EndMap;
-    sendEmitter(m_socketD, emitter);
-    receive_and_check_reply();
+    check_reply(request(emitter));
+}
+
+std::future<UmlClient::Pointer<Element>> UmlClient::get_async(ID id) {
+    // anything we have already is gotten without a request when the future is
+    if (this->loaded(id) || cached(id)) {
+        return std::async(std::launch::deferred, [this, id] {
+            return BaseManager::get(id);
+        });
+    }
+    return std::async(std::launch::deferred, [this, id, reply = request_async(get_request(id))]() mutable {
+        if (!this->loaded(id)) {
+            // stash the body so get takes it instead of asking again
+            accept_element(id, reply.get());
+            cache_element(id);
+        }
+        return BaseManager::get(id);
+    });
 }
 
 }
@@ -1,18 +1,29 @@
 #include "uml/uml-stable.h"
 #include "uml-server/umlServer.h"
 #include <expected>
+#include <algorithm>
 #ifndef WIN32
 #include <sys/socket.h>
+#include <sys/un.h>
 #include <sys/types.h>
 #include <netdb.h>
 #include <iostream>
 #include <unistd.h>
 #include <poll.h>
 #include <netinet/tcp.h>
+#include <fcntl.h>
 #else
 #include <ws2tcpip.h>
 #include <stdio.h>
 #endif
+#ifdef UML_SERVER_IO_URING
+#include <liburing.h>
+#include <sys/eventfd.h>
+#endif
+#ifdef __linux__
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
 #include <thread>
 #include <yaml-cpp/yaml.h>
 #include "uml/uml-stable.h"
@@ -22,6 +33,11 @@
 #include <errno.h>
 #include <string.h>
 #include <format>
+#include <charconv>
+#include <deque>
+#include <set>
+#include <unordered_set>
+#include <vector>
 
 #ifdef WIN32
 typedef size_t ssize_t;
@@ -34,46 +50,245 @@ using ElementPtr = UmlServer::Pointer<Element>;
 using NamedElementPtr = UmlServer::Pointer<NamedElement>;
 
 namespace UML {
-void send_message(int socket, std::string& data) {
-    uint64_t dataSize = data.size();
-    uint64_t dataSizeNetwork = htobe64(dataSize);
-    send(socket, &dataSizeNetwork, sizeof(uint64_t), 0);
+// a peer that went away makes send fail instead of raising SIGPIPE, which would kill the whole server
+#ifdef MSG_NOSIGNAL
+static constexpr int SEND_FLAGS = MSG_NOSIGNAL;
+#else
+static constexpr int SEND_FLAGS = 0;
+#endif
+
+static void send_all(int socket, const char* data_buffer, uint64_t data_size) {
     uint64_t total_bytes_sent = 0;
-    const char* data_buffer = data.c_str();
-    while (total_bytes_sent < dataSize) {
-        int bytesSent = send(socket, data_buffer + total_bytes_sent, dataSize, 0);
+    while (total_bytes_sent < data_size) {
+        ssize_t bytesSent = send(socket, data_buffer + total_bytes_sent, data_size - total_bytes_sent, SEND_FLAGS);
         if (bytesSent <= 0) {
-            throw ManagerStateException();
+            throw ManagerStateException("could not send message, error: " + std::string(strerror(errno)));
         }
         total_bytes_sent += bytesSent;
-        dataSize -= bytesSent;
     }
 }
 
+void send_message(int socket, std::string& data) {
+    uint64_t dataSizeNetwork = htobe64(data.size());
+    send_all(socket, reinterpret_cast<const char*>(&dataSizeNetwork), sizeof(uint64_t));
+    send_all(socket, data.c_str(), data.size());
+}
+
+// false once the peer closed or the socket failed before all of size came in
+static bool receive_all(int socket, char* buffer, std::size_t size) {
+    std::size_t bytes_read = 0;
+    while (bytes_read < size) {
+        ssize_t chunk_read = recv(socket, buffer + bytes_read, size - bytes_read, 0);
+        if (chunk_read <= 0) {
+            return false;
+        }
+        bytes_read += chunk_read;
+    }
+    return true;
+}
+
 std::optional<std::string> receive_message(int socket) {
+    // the size can come in pieces just like the message
     uint64_t message_size_buffer;
-    uint64_t bytes_read = recv(socket, &message_size_buffer, sizeof(uint64_t), 0);
-    if (bytes_read <= 0) {
+    if (!receive_all(socket, reinterpret_cast<char*>(&message_size_buffer), sizeof(uint64_t))) {
         return std::nullopt;
     }
-
-    // TODO check bytes_read == sizeof(uint64_t) and try to read rest
-    
-    // get rest of message 
     message_size_buffer = be64toh(message_size_buffer);
 
     if (message_size_buffer > SIZE_MAX) {
         return std::nullopt;
     }
 
-    char* message_buffer = (char*) calloc(message_size_buffer + 1, sizeof(char));
-    message_buffer[message_size_buffer] = '\0';
-    bytes_read = 0;
-    while ((bytes_read += recv(socket, message_buffer + bytes_read, message_size_buffer - bytes_read, 0)) < message_size_buffer) {}
-    std::string message_string = std::move(message_buffer);
-    free(message_buffer);
+    std::string message_string(message_size_buffer, '\0');
+    if (!receive_all(socket, message_string.data(), message_size_buffer)) {
+        return std::nullopt;
+    }
     return message_string;
 }
+
+#ifdef __linux__
+// a message sent through shared memory is a frame of {"shared_memory":size} with the memfd holding it attached
+static constexpr std::string_view SHARED_MEMORY_FRAME_PREFIX = "{\"shared_memory\":";
+
+bool send_shared_message(int socket, std::string& data) {
+    int memory_fd = memfd_create("uml-server-message", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (memory_fd == -1) {
+        return false;
+    }
+    if (ftruncate(memory_fd, data.size()) == -1) {
+        close(memory_fd);
+        return false;
+    }
+    void* memory = mmap(0, data.size(), PROT_WRITE, MAP_SHARED, memory_fd, 0);
+    if (memory == MAP_FAILED) {
+        close(memory_fd);
+        return false;
+    }
+    memcpy(memory, data.data(), data.size());
+    munmap(memory, data.size());
+
+    // sealed so the peer can map it without worrying about it changing size or contents under it
+    if (fcntl(memory_fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL) == -1) {
+        close(memory_fd);
+        return false;
+    }
+
+    std::string frame = std::string(SHARED_MEMORY_FRAME_PREFIX) + std::to_string(data.size()) + "}";
+    uint64_t frame_size_network = htobe64(frame.size());
+    struct iovec frame_size_iov = { &frame_size_network, sizeof(uint64_t) };
+    char control_buffer[CMSG_SPACE(sizeof(int))];
+    memset(control_buffer, 0, sizeof control_buffer);
+    struct msghdr header_msg;
+    memset(&header_msg, 0, sizeof header_msg);
+    header_msg.msg_iov = &frame_size_iov;
+    header_msg.msg_iovlen = 1;
+    header_msg.msg_control = control_buffer;
+    header_msg.msg_controllen = sizeof control_buffer;
+    struct cmsghdr* control_msg = CMSG_FIRSTHDR(&header_msg);
+    control_msg->cmsg_level = SOL_SOCKET;
+    control_msg->cmsg_type = SCM_RIGHTS;
+    control_msg->cmsg_len = CMSG_LEN(sizeof(int));
+    memcpy(CMSG_DATA(control_msg), &memory_fd, sizeof(int));
+    ssize_t header_sent = sendmsg(socket, &header_msg, MSG_NOSIGNAL);
+    // the peer holds its own copy of the descriptor once it is sent
+    close(memory_fd);
+    if (header_sent != sizeof(uint64_t)) {
+        throw ManagerStateException();
+    }
+    const char* frame_buffer = frame.c_str();
+    std::size_t frame_bytes_sent = 0;
+    while (frame_bytes_sent < frame.size()) {
+        ssize_t bytes_sent = send(socket, frame_buffer + frame_bytes_sent, frame.size() - frame_bytes_sent, MSG_NOSIGNAL);
+        if (bytes_sent <= 0) {
+            throw ManagerStateException();
+        }
+        frame_bytes_sent += bytes_sent;
+    }
+    return true;
+}
+
+std::optional<std::string> receive_any_message(int socket) {
+    // the size is read with recvmsg to pick up the memfd attached to it if it came through shared memory
+    uint64_t message_size_buffer;
+    char control_buffer[CMSG_SPACE(sizeof(int))];
+    int memory_fd = -1;
+    std::size_t size_bytes_read = 0;
+    while (size_bytes_read < sizeof(uint64_t)) {
+        struct iovec size_iov = { (char*) &message_size_buffer + size_bytes_read, sizeof(uint64_t) - size_bytes_read };
+        struct msghdr header_msg;
+        memset(&header_msg, 0, sizeof header_msg);
+        header_msg.msg_iov = &size_iov;
+        header_msg.msg_iovlen = 1;
+        header_msg.msg_control = control_buffer;
+        header_msg.msg_controllen = sizeof control_buffer;
+        ssize_t bytes_read = recvmsg(socket, &header_msg, MSG_CMSG_CLOEXEC);
+        if (bytes_read <= 0) {
+            if (memory_fd != -1) {
+                close(memory_fd);
+            }
+            return std::nullopt;
+        }
+        for (struct cmsghdr* control_msg = CMSG_FIRSTHDR(&header_msg); control_msg; control_msg = CMSG_NXTHDR(&header_msg, control_msg)) {
+            if (control_msg->cmsg_level == SOL_SOCKET && control_msg->cmsg_type == SCM_RIGHTS) {
+                memcpy(&memory_fd, CMSG_DATA(control_msg), sizeof(int));
+            }
+        }
+        size_bytes_read += bytes_read;
+    }
+    message_size_buffer = be64toh(message_size_buffer);
+    std::string message_string(message_size_buffer, '\0');
+    std::size_t bytes_read = 0;
+    while (bytes_read < message_size_buffer) {
+        ssize_t chunk_read = recv(socket, message_string.data() + bytes_read, message_size_buffer - bytes_read, 0);
+        if (chunk_read <= 0) {
+            if (memory_fd != -1) {
+                close(memory_fd);
+            }
+            return std::nullopt;
+        }
+        bytes_read += chunk_read;
+    }
+    if (memory_fd == -1) {
+        return message_string;
+    }
+
+    // {"shared_memory":size}, the message itself is in the memfd
+    std::size_t shared_size = 0;
+    if (message_string.starts_with(SHARED_MEMORY_FRAME_PREFIX)) {
+        shared_size = std::strtoull(message_string.c_str() + SHARED_MEMORY_FRAME_PREFIX.size(), 0, 10);
+    }
+    struct stat memory_stat;
+    if (shared_size == 0 || fstat(memory_fd, &memory_stat) == -1 || static_cast<std::size_t>(memory_stat.st_size) < shared_size) {
+        close(memory_fd);
+        return std::nullopt;
+    }
+    void* memory = mmap(0, shared_size, PROT_READ, MAP_SHARED, memory_fd, 0);
+    close(memory_fd);
+    if (memory == MAP_FAILED) {
+        return std::nullopt;
+    }
+    std::string shared_message(static_cast<const char*>(memory), shared_size);
+    munmap(memory, shared_size);
+    return shared_message;
+}
+#endif
+}
+
+// apply the set, unset, add and remove fields of a patch request to the body of an emitted element
+static void apply_patch(YAML::Node body_node, YAML::Node patch_node) {
+    if (patch_node["set"]) {
+        for (auto set_pair : patch_node["set"]) {
+            body_node[set_pair.first.as<std::string>()] = set_pair.second;
+        }
+    }
+    if (patch_node["unset"]) {
+        for (auto unset_node : patch_node["unset"]) {
+            body_node.remove(unset_node.as<std::string>());
+        }
+    }
+    if (patch_node["add"]) {
+        for (auto add_pair : patch_node["add"]) {
+            std::string set_name = add_pair.first.as<std::string>();
+            YAML::Node set_node = body_node[set_name];
+            std::unordered_set<std::string> present;
+            if (!set_node.IsSequence()) {
+                set_node = YAML::Node(YAML::NodeType::Sequence);
+            }
+            for (auto value_node : set_node) {
+                present.insert(value_node.as<std::string>());
+            }
+            for (auto value_node : add_pair.second) {
+                if (present.insert(value_node.as<std::string>()).second) {
+                    set_node.push_back(value_node.as<std::string>());
+                }
+            }
+            body_node[set_name] = set_node;
+        }
+    }
+    if (patch_node["remove"]) {
+        for (auto remove_pair : patch_node["remove"]) {
+            std::string set_name = remove_pair.first.as<std::string>();
+            YAML::Node set_node = body_node[set_name];
+            if (!set_node.IsSequence()) {
+                continue;
+            }
+            std::unordered_set<std::string> to_remove;
+            for (auto value_node : remove_pair.second) {
+                to_remove.insert(value_node.as<std::string>());
+            }
+            YAML::Node remaining(YAML::NodeType::Sequence);
+            for (auto value_node : set_node) {
+                if (!to_remove.contains(value_node.as<std::string>())) {
+                    remaining.push_back(value_node.as<std::string>());
+                }
+            }
+            if (remaining.size() == 0) {
+                body_node.remove(set_name);
+            } else {
+                body_node[set_name] = remaining;
+            }
+        }
+    }
 }
 
 using ParameterPair = std::pair<std::string, std::string>;
@@ -86,7 +301,11 @@ using RequestInfo = std::pair<std::variant<ID, std::string>, std::vector<Paramet
 static std::expected<RequestInfo, std::string> parse_id_and_parms(std::string request_string) {
     auto has_question_mark = request_string.find("?");
     if (has_question_mark != std::string::npos) {
-        ID parsed_id = ID::fromString(request_string.substr(0, has_question_mark));
+        std::string request_path = request_string.substr(0, has_question_mark);
+        std::variant<ID, std::string> parsed_id = request_path;
+        if (ID::isValid(request_path)) {
+            parsed_id = ID::fromString(request_path);
+        }
         std::vector<std::pair<std::string, std::string>> parsed_parameters;
         auto get_request_parameters_string = request_string.substr(has_question_mark + 1);
         std::stringstream parameters_stream(get_request_parameters_string);
@@ -126,17 +345,53 @@ int check_id(YAML::Node id_node) {
     return 0;
 }
 
+// requests answered from the indices and versions alone, along with the fields any request can have, these only
+// read what other requests change so they are handled alongside each other
+static bool read_only_request(const YAML::Node& node) {
+    static const std::unordered_set<std::string> READ_ONLY_FIELDS = {
+        "lookup", "search", "referencedBy", "query", "generate_status", "validate", "rid", "client"
+    };
+    for (auto field_pair : node) {
+        if (!READ_ONLY_FIELDS.contains(field_pair.first.as<std::string>())) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// clients put the correlation id first, {"rid":n,...}
+static std::optional<std::uint64_t> peek_request_id(const std::string& buff) {
+    static constexpr std::string_view REQUEST_ID_PREFIX = "{\"rid\":";
+    if (!buff.starts_with(REQUEST_ID_PREFIX)) {
+        return std::nullopt;
+    }
+    std::uint64_t request_id = 0;
+    auto result = std::from_chars(buff.data() + REQUEST_ID_PREFIX.size(), buff.data() + buff.size(), request_id);
+    if (result.ec != std::errc()) {
+        return std::nullopt;
+    }
+    return request_id;
+}
+
 void UmlServer::handleMessage(ID id, std::string buff) {
-    std::lock_guard<std::mutex> handleLock(m_messageHandlerMtx);
-    ClientInfo& info = m_clients[id];
+    auto client = find_client(id);
+    if (!client) {
+        return;
+    }
+    ClientInfo& info = *client;
+    // correlation id of the request, read ahead of parsing so even a request that fails to parse gets its reply tagged
+    std::optional<std::uint64_t> rid = peek_request_id(buff);
     log("server got message from client(" + id.string() + "):\n" + std::string(buff));
 
     if (buff == "KILL") {
         std::string kill_response = "{\"shutdown\":\"success\"}";
         log(kill_response);
-        send_message(info.socket, kill_response);
-        info.handlerCv.notify_one();
-        shutdownServer();
+        reply(info, kill_response, rid);
+        // shutting down waits on the workers, so it can't run on one of them
+        std::lock_guard<std::mutex> killLck(m_killMtx);
+        if (!m_killThread) {
+            m_killThread = new std::thread(&UmlServer::shutdownServer, this);
+        }
         return;
     }
     
@@ -145,19 +400,84 @@ void UmlServer::handleMessage(ID id, std::string buff) {
         node = YAML::Load(buff);
     } catch (std::exception& e) {
         log(e.what());
-        std::string msg = std::string("{\"error\": ") + std::string(e.what()) + std::string("}");
+        YAML::Emitter error_emitter;
+        error_emitter << YAML::DoubleQuoted << e.what();
+        std::string msg = std::string("{\"error\":") + error_emitter.c_str() + "}";
         log(msg);
-        send_message(info.socket, msg);
+        reply(info, msg, rid);
         return;
     }   
     
     if (!node.IsMap()) {
         log("ERROR receiving message from client, invalid format!\nMessage:\n" + buff);
-        std::string msg = std::string("{\"error\":\"") + std::string("ERROR receiving message from client, invalid format!\nMessage:\n" + buff) + std::string("\"}");
+        YAML::Emitter error_emitter;
+        error_emitter << YAML::DoubleQuoted << "ERROR receiving message from client, invalid format!\nMessage:\n" + buff;
+        std::string msg = std::string("{\"error\":") + error_emitter.c_str() + "}";
         log(msg);
-        send_message(info.socket, msg);
+        reply(info, msg, rid);
+        return;
+    }
+
+    std::shared_lock<std::shared_mutex> sharedHandleLock(m_messageHandlerMtx, std::defer_lock);
+    std::unique_lock<std::shared_mutex> handleLock(m_messageHandlerMtx, std::defer_lock);
+    if (read_only_request(node)) {
+        sharedHandleLock.lock();
+    } else {
+        handleLock.lock();
+    }
+    // a request may add meta managers, generating one or loading one with what it gets, handshakes see them
+    // once the list is refreshed on the way out while the lock is still held
+    struct MetaManagerListRefresh {
+        UmlServer& server;
+        std::unique_lock<std::shared_mutex>& lock;
+        ~MetaManagerListRefresh() {
+            if (lock.owns_lock()) {
+                server.refresh_meta_manager_list();
+            }
+        }
+    } meta_manager_list_refresh { *this, handleLock };
+    if (node["rid"]) {
+        rid = node["rid"].as<std::uint64_t>();
+    }
+
+    // clients sharing a connection name themselves in every request
+    ID client_id = id;
+    ClientSubscriptions* client_subscriptions = &info.subscriptions;
+    if (node["client"]) {
+        auto attached_match = check_id(node["client"]) ? info.attached_clients.end() : info.attached_clients.find(ID::fromString(node["client"].as<std::string>()));
+        if (attached_match == info.attached_clients.end()) {
+            std::string msg = "{\"error\":\"client of request is not attached to this connection!\"}";
+            log(msg);
+            reply(info, msg, rid);
+            return;
+        }
+        client_id = attached_match->first;
+        client_subscriptions = &attached_match->second;
+    }
+
+    if (node["attach"] || node["detach"]) {
+        // {"attach":id} adds a client to this connection, the reply lists the meta managers as the handshake does
+        bool attaching = node["attach"].IsDefined();
+        auto attach_node = attaching ? node["attach"] : node["detach"];
+        if (check_id(attach_node)) {
+            std::string msg = "{\"error\":\"attach and detach requests must be an id!\"}";
+            log(msg);
+            reply(info, msg, rid);
+            return;
+        }
+        ID attached_id = ID::fromString(attach_node.as<std::string>());
+        std::string msg = "{\"status\":\"success\"}";
+        if (attaching) {
+            info.attached_clients[attached_id];
+            msg = "{\"status\":\"success\",\"meta_managers\":" + emit_meta_manager_list() + "}";
+        } else {
+            info.attached_clients.erase(attached_id);
+        }
+        reply(info, msg, rid);
+        log("client " + attached_id.string() + (attaching ? " attached to connection " : " detached from connection ") + id.string());
         return;
     }
+
     if (node["DELETE"] || node["delete"]) {
 
         auto delete_node = node["DELETE"] ? node["DELETE"] : node["delete"];
@@ -166,7 +486,7 @@ void UmlServer::handleMessage(ID id, std::string buff) {
             log("bad formatting for delete request!");
             std::string error_message = "{\"error\":\"Delete requests need to be in the format {\"delete\":id}\"}";
             log(error_message);
-            send_message(info.socket, error_message);
+            reply(info, error_message, rid);
             return;
         }
 
@@ -196,7 +516,7 @@ void UmlServer::handleMessage(ID id, std::string buff) {
             log("bad delete request, must specify an id!");
             std::string error_message = "{\"error\":\"Could not parse id in delete request\"}";
             log(error_message);
-            send_message(info.socket, error_message);
+            reply(info, error_message, rid);
             return;
         }
 
@@ -206,19 +526,30 @@ void UmlServer::handleMessage(ID id, std::string buff) {
             auto el_to_erase = meta_manager.get(elID);
             meta_manager.erase(*el_to_erase);
             log("erased element " + elID.string() + " from meta manager " + meta_manager_id.string());
+            unqueue_resident(elID);
         } else {
             try {
                 ElementPtr elToErase = get(elID);
+                std::size_t erased_type = elToErase->getElementType();
                 erase(*elToErase);
                 log("erased element " + elID.string());
-                std::lock_guard<std::mutex> garbageLck(m_garbageMtx);
-                m_releaseQueue.remove(elID);
-                m_numEls--;
+                unqueue_resident(elID);
+                client_subscriptions->cached.erase(elID);
+                notify_change(client_id, elID, erased_type, "delete", 0);
+                m_qualified_names.unindex(elID);
+                m_type_index.unindex(elID);
+                m_backlinks.unindex(elID);
+                m_name_index.unindex(elID);
+                for (auto& meta_manager_pair : meta_managers()) {
+                    meta_manager_pair.second.element_erased(elID);
+                }
             } catch (std::exception& e) {
                 log("exception encountered when trying to delete element: " + std::string(e.what()));
-                std::string error_message = std::format("{{\"error\":\"{}\"}}", e.what());
+                YAML::Emitter error_emitter;
+                error_emitter << YAML::DoubleQuoted << e.what();
+                std::string error_message = std::string("{\"error\":") + error_emitter.c_str() + "}";
                 log(error_message);
-                send_message(info.socket, error_message);
+                reply(info, error_message, rid);
                 return;
             }
         }
@@ -226,35 +557,454 @@ void UmlServer::handleMessage(ID id, std::string buff) {
         // send reply
         std::string reply_message = "{\"status\":\"success\"}";
         log(reply_message);
-        send_message(info.socket, reply_message);
+        reply(info, reply_message, rid);
     } else if (node["DUMP"] || node["dump"]) {
         std::string dump = this->dumpYaml();
-        send_message(info.socket, dump);
+        reply(info, dump, rid);
         log("dumped server data to client, data: " + dump);
     } else if (node["generate"]) {
         if (!node["generate"].IsScalar()) {
             std::string msg = "{\"error\":\"invalid generate request, must be a scalar of an id to generate!\"}"; 
-            send_message(info.socket, msg);
+            reply(info, msg, rid);
             log(msg);
             return;
         } else {
-            // generate the meta manager, send id of manager back
-            ID generation_root_id = ID::fromString(node["generate"].as<std::string>());
-            ID manager_id = generate(get(generation_root_id)->as<Element>());
-
-            std::ostringstream oss;
-            oss << "{\"manager\":\"" << manager_id.string() << "\"}";
-            std::string msg = oss.str();
-            send_message(info.socket, msg);
+            // generate request is of the form generation_root_id?background=true&manager=manager_id
+            auto parse_result = parse_id_and_parms(node["generate"].as<std::string>());
+            if (!parse_result || parse_result->first.index() != 0) {
+                std::string msg = "{\"error\":\"invalid generate request, must specify the id of the generation root!\"}";
+                reply(info, msg, rid);
+                log(msg);
+                return;
+            }
+
+            bool background = false;
+            ID manager_id = ID::nullID();
+            for (auto& parameter_pair : parse_result->second) {
+                if (parameter_pair.first == "background") {
+                    background = parameter_pair.second == "true";
+                } else if (parameter_pair.first == "manager") {
+                    manager_id = ID::fromString(parameter_pair.second);
+                } else {
+                    YAML::Emitter error_emitter;
+                    error_emitter << YAML::DoubleQuoted << "invalid parameter in generate request: " + parameter_pair.first;
+                    std::string msg = std::string("{\"error\":") + error_emitter.c_str() + "}";
+                    reply(info, msg, rid);
+                    log(msg);
+                    return;
+                }
+            }
+
+            // the thread of a finished job is joined once the handler lock is given up
+            std::thread* finished_thread = 0;
+            try {
+                if (manager_id == ID::nullID()) {
+                    // generate the meta manager, send id of manager back
+                    ID generation_root_id = std::get<ID>(parse_result->first);
+                    manager_id = generate_deferred(get(generation_root_id)->as<Element>());
+                } else {
+                    // extend an existing manager with what was added to its generation root
+                    if (m_generation_jobs.count(manager_id) && !m_generation_jobs.at(manager_id).done) {
+                        std::string msg = std::format("{{\"error\":\"manager {} is still generating\"}}", manager_id.string());
+                        reply(info, msg, rid);
+                        log(msg);
+                        return;
+                    }
+                    get_meta_manager(manager_id).rediscover_types();
+                }
+
+                if (background) {
+                    GenerationJob& job = m_generation_jobs[manager_id];
+                    finished_thread = job.thread;
+                    job.done = false;
+                    job.error.clear();
+                    job.thread = new std::thread(generationJob, this, manager_id);
+                } else {
+                    get_meta_manager(manager_id).discover_types();
+                }
+            } catch (std::exception& e) {
+                YAML::Emitter error_emitter;
+                error_emitter << YAML::DoubleQuoted << "could not generate manager: " + std::string(e.what());
+                std::string msg = std::string("{\"error\":") + error_emitter.c_str() + "}";
+                reply(info, msg, rid);
+                log(msg);
+                return;
+            }
+
+            // clients told of the manager may connect more clients right away, their handshakes must list it
+            refresh_meta_manager_list();
+            std::string msg = background ? 
+                std::format("{{\"manager\":\"{}\",\"status\":\"generating\"}}", manager_id.string()) :
+                std::format("{{\"manager\":\"{}\"}}", manager_id.string());
+            reply(info, msg, rid);
             log("generated manager with id " + manager_id.string());
+            if (finished_thread) {
+                handleLock.unlock();
+                finished_thread->join();
+                delete finished_thread;
+            }
+        }
+    } else if (node["generate_status"]) {
+        auto status_node = node["generate_status"];
+        if (check_id(status_node)) {
+            std::string msg = "{\"error\":\"invalid generate_status request, must be the id of a manager!\"}";
+            reply(info, msg, rid);
+            log(msg);
+            return;
+        }
+
+        ID manager_id = ID::fromString(status_node.as<std::string>());
+        if (!meta_managers().count(manager_id)) {
+            std::string msg = std::format("{{\"error\":\"no manager with id {}\"}}", manager_id.string());
+            reply(info, msg, rid);
+            log(msg);
+            return;
+        }
+
+        std::string status = "done";
+        auto job_match = m_generation_jobs.find(manager_id);
+        if (job_match != m_generation_jobs.end()) {
+            if (!job_match->second.error.empty()) {
+                YAML::Emitter error_emitter;
+                error_emitter << YAML::DoubleQuoted << job_match->second.error;
+                std::string msg = std::format(
+                        "{{\"manager\":\"{}\",\"status\":\"error\",\"error\":{}}}", 
+                        manager_id.string(), 
+                        error_emitter.c_str()
+                    );
+                reply(info, msg, rid);
+                log(msg);
+                return;
+            }
+            if (!job_match->second.done) {
+                status = "generating";
+            }
+        }
+        std::string msg = std::format(
+                "{{\"manager\":\"{}\",\"status\":\"{}\",\"types\":{}}}", 
+                manager_id.string(), 
+                status, 
+                get_meta_manager(manager_id).num_types()
+            );
+        reply(info, msg, rid);
+        log(msg);
+    } else if (node["lookup"]) {
+        // lookup request is of the form {"lookup":{"prefix":"root::pack","limit":50}}
+        auto lookup_node = node["lookup"];
+        if (!lookup_node.IsMap() || !lookup_node["prefix"] || !lookup_node["prefix"].IsScalar()) {
+            std::string msg = "{\"error\":\"invalid lookup request, must be a map with a scalar prefix!\"}";
+            reply(info, msg, rid);
+            log(msg);
+            return;
+        }
+        std::size_t limit = UML_SERVER_LOOKUP_LIMIT;
+        if (lookup_node["limit"]) {
+            limit = lookup_node["limit"].as<std::size_t>();
+        }
+
+        std::string msg = "{\"matches\":[";
+        bool first_match = true;
+        for (auto& match_id : m_qualified_names.lookup_prefix(lookup_node["prefix"].as<std::string>(), limit)) {
+            auto match_name = m_qualified_names.qualified_name(match_id);
+            if (!first_match) {
+                msg += ",";
+            }
+            YAML::Emitter name_emitter;
+            name_emitter << YAML::DoubleQuoted << (match_name ? *match_name : "");
+            msg += std::format("{{\"id\":\"{}\",\"qualifiedName\":{}}}", match_id.string(), name_emitter.c_str());
+            first_match = false;
+        }
+        msg += "]}";
+        reply(info, msg, rid);
+        log(msg);
+    } else if (node["shared_memory"]) {
+        // {"shared_memory":true} has big replies to the client come through a memfd passed over the socket,
+        // which only works for clients connected over the unix domain socket
+        bool enable = node["shared_memory"].IsScalar() && node["shared_memory"].as<bool>(false);
+        #ifdef __linux__
+        struct sockaddr_storage socket_address;
+        socklen_t socket_address_size = sizeof socket_address;
+        bool unix_socket = getsockname(info.socket, (struct sockaddr*) &socket_address, &socket_address_size) == 0 && socket_address.ss_family == AF_UNIX;
+        #else
+        bool unix_socket = false;
+        #endif
+        if (enable && !unix_socket) {
+            std::string msg = "{\"error\":\"shared memory is only available to clients connected over a unix domain socket!\"}";
+            reply(info, msg, rid);
+            log(msg);
+            return;
+        }
+        info.shared_memory = enable;
+        std::string msg = "{\"status\":\"success\"}";
+        reply(info, msg, rid);
+        log("client " + id.string() + (enable ? " gets" : " no longer gets") + " big replies through shared memory");
+    } else if (node["validate"]) {
+        // validate request is of the form {"validate":{"epoch":epoch,"elements":{id:version}}} and is answered with
+        // {"epoch":epoch,"stale":[ids]}, every element is stale if the epoch is not this server's
+        auto validate_node = node["validate"];
+        if (!validate_node.IsMap() || (validate_node["elements"] && !validate_node["elements"].IsMap())) {
+            std::string msg = "{\"error\":\"invalid validate request, must be a map with a map of elements!\"}";
+            reply(info, msg, rid);
+            log(msg);
+            return;
+        }
+        bool same_epoch = validate_node["epoch"] && validate_node["epoch"].as<std::string>() == m_epoch.string();
+        std::string msg = std::format("{{\"epoch\":\"{}\",\"stale\":[", m_epoch.string());
+        std::size_t num_elements = 0;
+        std::size_t num_stale = 0;
+        for (auto element_pair : validate_node["elements"]) {
+            num_elements++;
+            if (check_id(element_pair.first)) {
+                continue;
+            }
+            ID validated_id = ID::fromString(element_pair.first.as<std::string>());
+            if (same_epoch && element_pair.second.as<std::uint64_t>() == version_of(validated_id)) {
+                track_cached(*client_subscriptions, validated_id);
+                continue;
+            }
+            if (num_stale) {
+                msg += ",";
+            }
+            msg += "\"" + validated_id.string() + "\"";
+            num_stale++;
+        }
+        msg += "]}";
+        reply(info, msg, rid);
+        log("validated " + std::to_string(num_elements) + " elements for client " + id.string() + ", " + std::to_string(num_stale) + " stale");
+    } else if (node["subscribe"] || node["unsubscribe"]) {
+        // subscribe requests are of the form {"subscribe":{"element":id}}, {"subscribe":{"subtree":id}}
+        // or {"subscribe":{"type":"Class"}}, with "body":true to get the new emit along with changes.
+        // {"subscribe":{"cache":true}} has the server invalidate what the client gets and saves whenever
+        // another client changes it
+        bool subscribing = node["subscribe"].IsDefined();
+        auto subscription_node = subscribing ? node["subscribe"] : node["unsubscribe"];
+        if (!subscription_node.IsMap()) {
+            std::string msg = "{\"error\":\"invalid subscription request, must be a map!\"}";
+            reply(info, msg, rid);
+            log(msg);
+            return;
+        }
+
+        auto& subscriptions = *client_subscriptions;
+        for (std::string scope : {"element", "subtree"}) {
+            auto scope_node = subscription_node[scope];
+            if (!scope_node) {
+                continue;
+            }
+            if (check_id(scope_node)) {
+                std::string msg = std::format("{{\"error\":\"invalid subscription request, {} must be an id!\"}}", scope);
+                reply(info, msg, rid);
+                log(msg);
+                return;
+            }
+            auto& ids = scope == "element" ? subscriptions.elements : subscriptions.subtrees;
+            ID scope_id = ID::fromString(scope_node.as<std::string>());
+            if (subscribing) {
+                ids.insert(scope_id);
+            } else {
+                ids.erase(scope_id);
+            }
+        }
+        if (subscription_node["type"]) {
+            auto type_match = names_to_element_type.find(subscription_node["type"].as<std::string>());
+            if (type_match == names_to_element_type.end()) {
+                std::string msg = std::format("{{\"error\":\"invalid subscription request, no type named {}\"}}", subscription_node["type"].as<std::string>());
+                reply(info, msg, rid);
+                log(msg);
+                return;
+            }
+            if (subscribing) {
+                subscriptions.types.insert(type_match->second);
+            } else {
+                subscriptions.types.erase(type_match->second);
+            }
+        }
+        if (subscribing && subscription_node["body"]) {
+            subscriptions.bodies = subscription_node["body"].as<bool>();
         }
+        if (subscription_node["cache"]) {
+            subscriptions.cache = subscribing && subscription_node["cache"].as<bool>();
+            if (!subscriptions.cache) {
+                subscriptions.cached.clear();
+            }
+        }
+
+        if (!info.sender && !subscriptions.empty()) {
+            info.sender = new std::thread(clientSender, this, id);
+        }
+
+        std::string msg = "{\"status\":\"success\"}";
+        reply(info, msg, rid);
+        log("client " + id.string() + (subscribing ? " subscribed" : " unsubscribed"));
+    } else if (node["uncache"]) {
+        // {"uncache":[ids]} the client let go of these, so it is not told when they change anymore
+        auto uncache_node = node["uncache"];
+        if (!uncache_node.IsSequence()) {
+            std::string msg = "{\"error\":\"invalid uncache request, must be a sequence of ids!\"}";
+            reply(info, msg, rid);
+            log(msg);
+            return;
+        }
+        for (auto uncached_node : uncache_node) {
+            if (!check_id(uncached_node)) {
+                client_subscriptions->cached.erase(ID::fromString(uncached_node.as<std::string>()));
+            }
+        }
+        std::string msg = "{\"status\":\"success\"}";
+        reply(info, msg, rid);
+    } else if (node["search"]) {
+        // search request is of the form {"search":{"name":"Foo","mode":"prefix","caseSensitive":false,"limit":20}}
+        auto search_node = node["search"];
+        if (!search_node.IsMap() || !search_node["name"] || !search_node["name"].IsScalar()) {
+            std::string msg = "{\"error\":\"invalid search request, must be a map with a scalar name!\"}";
+            reply(info, msg, rid);
+            log(msg);
+            return;
+        }
+
+        NameIndex::SearchMode mode = NameIndex::SearchMode::PREFIX;
+        if (search_node["mode"]) {
+            std::string mode_string = search_node["mode"].as<std::string>();
+            if (mode_string == "exact") {
+                mode = NameIndex::SearchMode::EXACT;
+            } else if (mode_string != "prefix") {
+                std::string msg = "{\"error\":\"invalid search request, mode must be exact or prefix!\"}";
+                reply(info, msg, rid);
+                log(msg);
+                return;
+            }
+        }
+        bool case_sensitive = search_node["caseSensitive"] && search_node["caseSensitive"].as<bool>();
+        std::size_t limit = search_node["limit"] ? search_node["limit"].as<std::size_t>() : UML_SERVER_SEARCH_LIMIT;
+
+        std::string msg = "{\"ids\":[";
+        bool first_id = true;
+        for (auto& match_id : m_name_index.search(search_node["name"].as<std::string>(), mode, case_sensitive, limit)) {
+            msg += first_id ? "\"" : ",\"";
+            msg += match_id.string() + "\"";
+            first_id = false;
+        }
+        msg += "]}";
+        reply(info, msg, rid);
+        log(msg);
+    } else if (node["referencedBy"]) {
+        // referencedBy request is of the form {"referencedBy":"id"}, answered from the backlink index
+        // and the stereotype applications of the meta managers without loading anything
+        auto referenced_node = node["referencedBy"];
+        if (check_id(referenced_node)) {
+            std::string msg = "{\"error\":\"invalid referencedBy request, must be the id of an element!\"}";
+            reply(info, msg, rid);
+            log(msg);
+            return;
+        }
+        ID target_id = ID::fromString(referenced_node.as<std::string>());
+        std::string msg = "{\"references\":[";
+        bool first_reference = true;
+        for (auto& reference : m_backlinks.referenced_by(target_id)) {
+            msg += first_reference ? "" : ",";
+            msg += std::format("{{\"id\":\"{}\",\"set\":\"{}\"}}", reference.first.string(), reference.second);
+            first_reference = false;
+        }
+        for (auto& applied_pair : applied_meta_elements(target_id)) {
+            msg += first_reference ? "" : ",";
+            msg += std::format(
+                    "{{\"id\":\"{}\",\"set\":\"applying_element\",\"manager\":\"{}\"}}", 
+                    applied_pair.second.string(), 
+                    applied_pair.first.string()
+                );
+            first_reference = false;
+        }
+        msg += "]}";
+        reply(info, msg, rid);
+        log(msg);
+    } else if (node["query"]) {
+        // query request is of the form {"query":{"type":"Class","under":"id","after":"id","limit":100}}
+        // replies hold a page of ids and the id to continue after, null once there are no more. Elements
+        // of types inheriting from type match as well, type may be abstract, e.g. Classifier
+        auto query_node = node["query"];
+        if (!query_node.IsMap() || !query_node["type"] || !query_node["type"].IsScalar()) {
+            std::string msg = "{\"error\":\"invalid query request, must be a map with a scalar type!\"}";
+            reply(info, msg, rid);
+            log(msg);
+            return;
+        }
+
+        std::string type_name = query_node["type"].as<std::string>();
+        auto type_match = names_to_element_type.find(type_name);
+        auto abstract_type_match = names_to_abstract_element_type.find(type_name);
+        if (type_match == names_to_element_type.end() && abstract_type_match == names_to_abstract_element_type.end()) {
+            std::string msg = std::format("{{\"error\":\"invalid query request, no type named {}\"}}", type_name);
+            reply(info, msg, rid);
+            log(msg);
+            return;
+        }
+        std::size_t element_type = type_match != names_to_element_type.end() ? type_match->second : abstract_type_match->second;
+
+        ID under_id = ID::nullID();
+        if (query_node["under"]) {
+            if (check_id(query_node["under"])) {
+                std::string msg = "{\"error\":\"invalid query request, under must be an id!\"}";
+                reply(info, msg, rid);
+                log(msg);
+                return;
+            }
+            under_id = ID::fromString(query_node["under"].as<std::string>());
+        }
+        std::string after = query_node["after"] ? query_node["after"].as<std::string>() : "";
+        std::size_t limit = query_node["limit"] ? query_node["limit"].as<std::size_t>() : UML_SERVER_QUERY_LIMIT;
+
+        std::string msg = "{\"ids\":[";
+        std::size_t num_ids = 0;
+        std::string last_id;
+        bool more = false;
+        auto add_id = [&](const std::string& id_string) {
+            if (num_ids == limit) {
+                more = true;
+                return false;
+            }
+            msg += num_ids == 0 ? "\"" : ",\"";
+            msg += id_string + "\"";
+            last_id = id_string;
+            num_ids++;
+            return true;
+        };
+        if (under_id == ID::nullID()) {
+            m_type_index.for_each(element_type, after, add_id);
+        } else {
+            // walk what under owns rather than every element of the type, keeping only the first ids of the
+            // page in the same order as the type index
+            std::set<std::string> page_ids;
+            m_qualified_names.for_each_owned(under_id, [&](ID owned_id) {
+                if (!m_type_index.is(owned_id, element_type)) {
+                    return;
+                }
+                std::string id_string = owned_id.string();
+                if (id_string <= after) {
+                    return;
+                }
+                page_ids.insert(std::move(id_string));
+                if (page_ids.size() > limit + 1) {
+                    page_ids.erase(std::prev(page_ids.end()));
+                }
+            });
+            for (auto& id_string : page_ids) {
+                if (!add_id(id_string)) {
+                    break;
+                }
+            }
+        }
+        msg += more ? std::format("],\"next\":\"{}\"}}", last_id) : "],\"next\":null}";
+        reply(info, msg, rid);
+        log("answered query for " + std::to_string(num_ids) + " elements of type " + type_name);
     } else if (node["GET"] || node["get"]) {
         ID elID;
         ID manager_id;
+        std::optional<std::size_t> depth;
+        std::optional<std::uint64_t> known_version;
         YAML::Node getNode = (node["GET"] ? node["GET"] : node["get"]);
         if (!getNode.IsScalar()) {
             std::string msg = "{\"error\":\"invalid format for get request! Must be formatted as a scalar string!\"}";
-            send_message(info.socket, msg);
+            reply(info, msg, rid);
             log(msg);
             return;
         } else {
@@ -264,17 +1014,33 @@ void UmlServer::handleMessage(ID id, std::string buff) {
             if (!parse_result) {
                 std::string msg = "{\"error\":\"problem while parsing get request parameters: " + parse_result.error() + "\"}";
                 log(msg);
-                send_message(info.socket, msg);
+                reply(info, msg, rid);
                 return;
             }
 
             for (auto& parameter_pair : parse_result->second) {
                 if (parameter_pair.first == "manager") {
                     manager_id = ID::fromString(parameter_pair.second);
+                } else if (parameter_pair.first == "depth" || parameter_pair.first == "version") {
+                    // both are plain numbers, anything else is answered with an error instead of thrown
+                    std::uint64_t value = 0;
+                    const std::string& value_string = parameter_pair.second;
+                    auto result = std::from_chars(value_string.data(), value_string.data() + value_string.size(), value);
+                    if (value_string.empty() || result.ec != std::errc() || result.ptr != value_string.data() + value_string.size()) {
+                        std::string msg = "{\"error\":\"invalid " + parameter_pair.first + " in get request, must be a non negative integer\"}";
+                        log(msg);
+                        reply(info, msg, rid);
+                        return;
+                    }
+                    if (parameter_pair.first == "depth") {
+                        depth = value;
+                    } else {
+                        known_version = value;
+                    }
                 } else {
                     std::string msg = "{\"error\":\"invalid parameter in get request: " + parameter_pair.first + "\"}";
                     log(msg);
-                    send_message(info.socket, msg);
+                    reply(info, msg, rid);
                     return;
                 }
             }
@@ -291,12 +1057,47 @@ void UmlServer::handleMessage(ID id, std::string buff) {
             try {
                 if (manager_id == ID::nullID()) {
                     if (elID == ID::nullID()) {
-                        // TODO check url
-                        elID = m_urls.at(*url);
+                        auto lookup_result = m_qualified_names.lookup(*url);
+                        if (!lookup_result) {
+                            YAML::Emitter error_emitter;
+                            error_emitter << YAML::DoubleQuoted << "no element with qualified name " + *url;
+                            std::string msg = std::string("{\"error\":") + error_emitter.c_str() + "}";
+                            log(msg);
+                            reply(info, msg, rid);
+                            return;
+                        }
+                        elID = *lookup_result;
                     }
+                    bool was_loaded = this->loaded(elID);
                     ElementPtr el = abstractGet(elID);
+                    if (depth) {
+                        // subtree get, the element and what it owns down to depth in one json array
+                        std::string msg;
+                        std::size_t num_elements = emit_subtree(el, *depth, msg);
+                        if (!was_loaded) {
+                            queue_resident(ID::nullID(), elID);
+                        }
+                        reply(info, msg, rid);
+                        log("server got subtree of " + std::to_string(num_elements) + " elements under " + elID.string() + " for client " + id.string());
+                        return;
+                    }
+                    if (known_version) {
+                        // versioned get, {"id":id,"version":n} alone if the client already has version n,
+                        // otherwise with "element" holding the emit
+                        track_cached(*client_subscriptions, elID);
+                        std::uint64_t version = version_of(elID);
+                        std::string msg = std::format("{{\"id\":\"{}\",\"version\":{}", elID.string(), version);
+                        if (*known_version == version) {
+                            msg += "}";
+                        } else {
+                            msg += ",\"element\":" + this->emitIndividual(*el) + "}";
+                        }
+                        reply(info, msg, rid);
+                        log("server got version " + std::to_string(version) + " of element " + elID.string() + " for client " + id.string());
+                        return;
+                    }
                     std::string msg = this->emitIndividual(*el);
-                    send_message(info.socket, msg);
+                    reply(info, msg, rid);
                     log("server got element " +  elID.string() + " for client " + id.string() + ":\n" + msg);
                 } else {
                     MetaManager& meta_manager = get_meta_manager(manager_id);
@@ -304,13 +1105,22 @@ void UmlServer::handleMessage(ID id, std::string buff) {
                     // first check if we have a stereotyped element of this
                     auto stereotype_match = meta_manager.get_stereotyped_element(elID);
                     std::string msg;
+                    // restoring a meta element may load its uml mirror too, the mirror has the same id
+                    bool uml_was_loaded = this->loaded(elID);
                     if (stereotype_match) {
                         msg = this->emitIndividual(*stereotype_match);
-                        send_message(info.socket, msg);
+                        reply(info, msg, rid);
                     } else {
+                        bool was_loaded = meta_manager.loaded(elID);
                         MetaManager::Pointer<MetaElement> el = meta_manager.get(elID);
                         msg = meta_manager.emit_meta_element(*el);
-                        send_message(info.socket, msg);
+                        if (!was_loaded) {
+                            queue_resident(manager_id, elID);
+                        }
+                        reply(info, msg, rid);
+                    }
+                    if (!uml_was_loaded && this->loaded(elID)) {
+                        queue_resident(ID::nullID(), elID);
                     }
                     log("server got element " + elID.string() + " from manager " + manager_id.string() + " for client " + id.string() + " :\n" + msg);
                 }
@@ -318,7 +1128,7 @@ void UmlServer::handleMessage(ID id, std::string buff) {
                 log(e.what());
                 std::string msg = std::string("{\"ERROR\":\"") + std::string(e.what()) + std::string("\"}");
                 log(msg);
-                send_message(info.socket, msg);
+                reply(info, msg, rid);
                 return;
             } 
         }
@@ -326,6 +1136,7 @@ void UmlServer::handleMessage(ID id, std::string buff) {
         log("server handling post request from client " + id.string());
         try {
             ID id;
+            ID resident_manager_id = ID::nullID();
             auto postNode = node["POST"] ? node["POST"] : node["post"];
             if (postNode.IsScalar()) {
                 std::size_t type = names_to_element_type.at((node["POST"] ? node["POST"] : node["post"]).as<std::string>());
@@ -341,13 +1152,13 @@ void UmlServer::handleMessage(ID id, std::string buff) {
                         case NOT_SCALAR: {
                             std::string msg = "{\"error\":\"post request improperly formatted, manager must be a scalar!\"}";
                             log(msg);
-                            send_message(info.socket, msg);
+                            reply(info, msg, rid);
                             return;
                         }
                         case NOT_ID: {
                             std::string msg = "{\"error\":\"post request manager not a valid id!\"}";
                             log(msg);
-                            send_message(info.socket, msg);
+                            reply(info, msg, rid);
                             return;
                         }
                     }
@@ -371,7 +1182,7 @@ void UmlServer::handleMessage(ID id, std::string buff) {
                         case NOT_SCALAR: {
                             std::string msg = "{\"error\":\"type must be a scalar value for post requests!\"}";
                             log(msg);
-                            send_message(info.socket, msg);
+                            reply(info, msg, rid);
                             return;
                         }
                              
@@ -388,7 +1199,7 @@ void UmlServer::handleMessage(ID id, std::string buff) {
                             postNode["type"].as<std::string>()        
                         );
                         log(msg);
-                        send_message(info.socket, msg);
+                        reply(info, msg, rid);
                         return;
                     }
 
@@ -399,6 +1210,56 @@ void UmlServer::handleMessage(ID id, std::string buff) {
                         log("setting id of posted element to " + created_element.id().string());
                     } 
 
+                    auto applying_elements_node = postNode["applying_elements"];
+                    if (applying_elements_node) {
+                        // bulk application of a stereotype, one reply with the ids of every meta element created
+                        if (!applying_elements_node.IsSequence()) {
+                            std::string msg = "{\"error\":\"post request improperly formatted, applying_elements must be a sequence of ids!\"}";
+                            log(msg);
+                            reply(info, msg, rid);
+                            return;
+                        }
+
+                        // resolve every element first so a bad id does not leave the request half applied
+                        std::vector<UmlManager::Pointer<Element>> applying_elements;
+                        std::vector<ID> loaded_applying_ids;
+                        applying_elements.reserve(applying_elements_node.size());
+                        for (auto applying_element_id_node : applying_elements_node) {
+                            if (check_id(applying_element_id_node)) {
+                                std::string msg = "{\"error\":\"post request applying_elements must only contain valid ids!\"}";
+                                log(msg);
+                                reply(info, msg, rid);
+                                return;
+                            }
+                            ID applying_element_id = ID::fromString(applying_element_id_node.as<std::string>());
+                            if (!this->loaded(applying_element_id)) {
+                                loaded_applying_ids.push_back(applying_element_id);
+                            }
+                            applying_elements.push_back(get(applying_element_id));
+                        }
+
+                        auto created_elements = meta_manager.apply_all(applying_elements, *element_type_option);
+                        std::string reply_message = "{\"status\":\"success\",\"ids\":[";
+                        reply_message.reserve(reply_message.size() + created_elements.size() * 31 + 2);
+                        for (std::size_t i = 0; i < created_elements.size(); i++) {
+                            if (i != 0) {
+                                reply_message += ",";
+                            }
+                            reply_message += "\"" + created_elements[i].id().string() + "\"";
+                            queue_resident(manager_id, created_elements[i].id());
+                        }
+                        reply_message += "]}";
+                        queue_new_proxy_elements(meta_manager, manager_id);
+
+                        // the uml elements loaded to apply to are given back like the meta elements
+                        for (auto& applying_element_id : loaded_applying_ids) {
+                            queue_resident(ID::nullID(), applying_element_id);
+                        }
+                        reply(info, reply_message, rid);
+                        log("applied stereotype to " + std::to_string(created_elements.size()) + " elements for client " + id.string());
+                        return;
+                    }
+
                     auto applying_element_node = postNode["applying_element"];
                     if (applying_element_node) {
                         // post request is asking us to apply a stereotype from this manager
@@ -406,13 +1267,13 @@ void UmlServer::handleMessage(ID id, std::string buff) {
                             case NOT_SCALAR: {
                                 std::string msg = "{\"error\":\"post request improperly formatted, manager must be a scalar!\"}";
                                 log(msg);
-                                send_message(info.socket, msg);
+                                reply(info, msg, rid);
                                 return;
                             }
                             case NOT_ID: {
                                 std::string msg = "{\"error\":\"post request manager not a valid id!\"}";
                                 log(msg);
-                                send_message(info.socket, msg);
+                                reply(info, msg, rid);
                                 return;
                             }
                         }
@@ -422,6 +1283,8 @@ void UmlServer::handleMessage(ID id, std::string buff) {
                     } else {
                         created_element = meta_manager.create(*element_type_option, id_specified);
                     }
+                    resident_manager_id = manager_id;
+                    queue_new_proxy_elements(meta_manager, manager_id);
                 } else {
                     if (postNode["type"]) {
                         auto type = names_to_element_type.at(postNode["type"].as<std::string>());
@@ -463,17 +1326,20 @@ void UmlServer::handleMessage(ID id, std::string buff) {
                     } else {
                         std::string msg = "{\"error\":\"Must specify type when posting a uml element\"}";
                         log(msg);
-                        send_message(info.socket, msg);
+                        reply(info, msg, rid);
                         return;
                     }
                 }
+                id = created_element.id();
+                if (resident_manager_id == ID::nullID()) {
+                    index_element(created_element->as<Element>());
+                    notify_change(client_id, created_element.id(), created_element->getElementType(), "post", &*created_element);
+                }
             }
             std::string reply_message = "{\"status\":\"success\"}";
-            send_message(info.socket, reply_message);
+            reply(info, reply_message, rid);
             log(reply_message);
-            std::lock_guard<std::mutex> garbageLck(m_garbageMtx);
-            m_releaseQueue.push_front(id);
-            m_garbageCv.notify_one();
+            queue_resident(resident_manager_id, id);
         } catch (std::exception& e) {
             std::string error_message = std::format(
                     "{{\"error\":\"server could not create new element for client {} exception with request: {}\"}}",
@@ -481,15 +1347,16 @@ void UmlServer::handleMessage(ID id, std::string buff) {
                     e.what()
                 );
             log(error_message);
-            send_message(info.socket, error_message);
+            reply(info, error_message, rid);
             return;
         }
     } else if (node["PUT"] || node["put"]) {
         YAML::Node putNode = (node["PUT"] ? node["PUT"] : node["put"]);
+        std::optional<std::uint64_t> put_version;
         if (!putNode.IsMap()) {
             std::string msg = "{\"error\":\"Improper formatting for put request! Must be a map!\"}";
             log(msg);
-            send_message(info.socket, msg);
+            reply(info, msg, rid);
             return;
         }
 
@@ -498,14 +1365,14 @@ void UmlServer::handleMessage(ID id, std::string buff) {
             if (!manager_node.IsScalar()) {
                 std::string error_msg = "{\"error\":\"Bad format for put request manager field! Must be a scalar id!\"}";
                 log(error_msg);
-                send_message(info.socket, error_msg);
+                reply(info, error_msg, rid);
                 return;
             }
             
             if (!ID::isValid(manager_node.as<std::string>())) {
                 std::string error_msg = "{\"error\":\"Bad format for put request manager field! Improper id format!\"}";
                 log(error_msg);
-                send_message(info.socket, error_msg);
+                reply(info, error_msg, rid);
                 return;
             }
 
@@ -513,16 +1380,33 @@ void UmlServer::handleMessage(ID id, std::string buff) {
             if (!element_node.IsMap()) {
                 std::string error_msg = "{\"error\":\"Bad format for put request element field! Field must be a map!\"}";
                 log(error_msg);
-                send_message(info.socket, error_msg);
+                reply(info, error_msg, rid);
                 return;
             }
 
-            MetaManager& meta_manager = get_meta_manager(ID::fromString(manager_node.as<std::string>()));
+            ID manager_id = ID::fromString(manager_node.as<std::string>());
+            MetaManager& meta_manager = get_meta_manager(manager_id);
 
+            // an element put after it was released is resident again, and so is its uml mirror if parsing loads it
+            std::optional<ID> put_id;
+            for (auto body_pair : element_node) {
+                if (body_pair.second.IsMap() && !check_id(body_pair.second["id"])) {
+                    put_id = ID::fromString(body_pair.second["id"].as<std::string>());
+                }
+            }
+            bool was_loaded = put_id && meta_manager.loaded(*put_id);
+            bool uml_was_loaded = put_id && this->loaded(*put_id);
             auto el = meta_manager.parse_node(element_node);
             if (el) {
                 meta_manager.restoreElAndOpposites(el);
+                if (!was_loaded) {
+                    queue_resident(manager_id, el.id());
+                }
+                if (!uml_was_loaded && this->loaded(el.id())) {
+                    queue_resident(ID::nullID(), el.id());
+                }
             }
+            queue_new_proxy_elements(meta_manager, manager_id);
             log("put element " + el.id().string() + " to meta manager " + manager_node.as<std::string>() + " for client " + id.string() + " succesfully!");
         } else {
             try {
@@ -531,16 +1415,16 @@ void UmlServer::handleMessage(ID id, std::string buff) {
                     // run add policies we skipped over
                     restoreElAndOpposites(el);
                 }
-                bool isRoot = false;
-                if (putNode["qualifiedName"]) {
-                    if (putNode["qualifiedName"].as<std::string>().compare("") == 0) {
-                        isRoot = true;
-                    }
-                    m_urls[putNode["qualifiedName"].as<std::string>()] = el.id();
-                }
+                // qualified names are derived from the element itself, the field only marks the root
+                bool isRoot = putNode["qualifiedName"] && putNode["qualifiedName"].as<std::string>().empty();
                 if (isRoot) {
                     setRoot(*el);
+                } else {
+                    index_element(*el);
                 }
+                notify_change(client_id, el.id(), el->getElementType(), "put", &*el);
+                track_cached(*client_subscriptions, el.id());
+                put_version = version_of(el.id());
                 log("server put element " + el.id().string() + " successfully for client " + id.string());
             } catch (std::exception& e) {
                 log("Error parsing PUT request: " + std::string(e.what()));
@@ -548,211 +1432,1088 @@ void UmlServer::handleMessage(ID id, std::string buff) {
                         "{{\"error\":\"Error parsing put request {}\"}}",
                         e.what()    
                     );
-                send_message(info.socket, error_message);
+                reply(info, error_message, rid);
                 return;
             }
         }
         std::string reply_message = "{\"status\":\"success\"}";
+        if (put_version) {
+            reply_message = std::format("{{\"status\":\"success\",\"version\":{}}}", *put_version);
+        }
+        log(reply_message);
+        reply(info, reply_message, rid);
+    } else if (node["PATCH"] || node["patch"]) {
+        // patch requests carry only what changed in the body of an element, this saves bandwidth only, the server
+        // still applies them by patching the emit of the element and parsing it back like a put
+        // {"PATCH":{"id":id,"set":{"name":"foo"},"unset":["visibility"],"add":{"packagedElements":[ids]},"remove":{"packagedElements":[ids]}}}
+        YAML::Node patchNode = (node["PATCH"] ? node["PATCH"] : node["patch"]);
+        std::uint64_t patch_version = 0;
+        if (!patchNode.IsMap() || check_id(patchNode["id"])) {
+            std::string msg = "{\"error\":\"Improper formatting for patch request! Must be a map with the id of the element!\"}";
+            log(msg);
+            reply(info, msg, rid);
+            return;
+        }
+
+        try {
+            ID patched_id = ID::fromString(patchNode["id"].as<std::string>());
+            ElementPtr current = get(patched_id);
+            YAML::Node element_node = YAML::Load(this->emitIndividual(*current));
+            YAML::Node body_node;
+            for (auto top_level_pair : element_node) {
+                if (top_level_pair.second.IsMap() && names_to_element_type.contains(top_level_pair.first.as<std::string>())) {
+                    body_node = top_level_pair.second;
+                    break;
+                }
+            }
+            if (!body_node) {
+                throw ManagerStateException("could not find body of element to patch");
+            }
+            apply_patch(body_node, patchNode);
+
+            ElementPtr el = parseNode(element_node);
+            if (!el) {
+                throw ManagerStateException("could not parse patched element");
+            }
+            restoreElAndOpposites(el);
+            index_element(*el);
+            notify_change(client_id, el.id(), el->getElementType(), "put", &*el);
+            track_cached(*client_subscriptions, el.id());
+            patch_version = version_of(el.id());
+            log("server patched element " + el.id().string() + " successfully for client " + id.string());
+        } catch (std::exception& e) {
+            log("Error handling PATCH request: " + std::string(e.what()));
+            YAML::Emitter error_emitter;
+            error_emitter << YAML::DoubleQuoted << "Error handling patch request " + std::string(e.what());
+            std::string error_message = std::string("{\"error\":") + error_emitter.c_str() + "}";
+            reply(info, error_message, rid);
+            return;
+        }
+        std::string reply_message = std::format("{{\"status\":\"success\",\"version\":{}}}", patch_version);
         log(reply_message);
-        send_message(info.socket, reply_message);
+        reply(info, reply_message, rid);
     } else if (node["SAVE"] || node["save"]) {
         YAML::Node saveNode = (node["SAVE"] ? node["SAVE"] : node["save"]);
         std::string path = saveNode.as<std::string>();
         try {
-            if (path.empty()) {
-                save();
-            } else {
-                save(path);
+            if (path.empty()) {
+                save();
+            } else {
+                save(path);
+            }
+        } catch (std::exception& e) {
+            log("ERROR saving element, error: " + std::string(e.what()));
+            std::string error_message = std::format(
+                    "{{\"error\":\"error saving element: {}\"}}",
+                    e.what()    
+                );
+            reply(info, error_message, rid);
+            return;
+        }
+        log("saved element to " + path);
+        std::string reply_message = "{\"status\":\"success\"}";
+        log(reply_message);
+        reply(info, reply_message, rid);
+    } else {
+        log("ERROR receiving message from client, invalid format!\nMessage:\n" + buff);
+        std::string msg = "{\"error\":\"ERROR receiving message from client, invalid format!\"}";
+        reply(info, msg, rid);
+        return;
+    }
+    log("Done processing message");
+}
+
+void UmlServer::receiveFromClient(UmlServer* me, ID id) {
+
+    /**
+     * TODO: lossless receive, client can rapidfire messages
+     **/
+
+    me->log("server set up thread to listen to client " + id.string());
+    auto client = me->find_client(id);
+    if (!client) {
+        return;
+    }
+    ClientInfo& info = *client;
+    while (me->m_running) {
+        // receive message
+        auto message_option = receive_message(info.socket);
+        if (!message_option) {
+            me->log(std::format("ERROR: fatal client error for client {}", id.string()));
+            me->queue_zombie(id);
+            return;
+        }
+
+        // dispatch message
+        me->queue_request(id, std::move(*message_option));
+        me->log("receive from client thread added new message to threadQueue");
+    }
+}
+
+void UmlServer::acceptNewClients(UmlServer* me, socketType listener, bool primary) {
+    // the thread on m_socketD also accepts from the unix socket, the primary one is the one shutting down waits on
+    struct pollfd pfds[2] = {{listener, POLLIN}, {me->m_unixSocketD, POLLIN}};
+    #ifndef WIN32
+    nfds_t num_listeners = listener != me->m_socketD || me->m_unixSocketD == -1 ? 1 : 2;
+    #endif
+    {
+        std::unique_lock<std::mutex> rLck(me->m_runMtx, std::defer_lock);
+        if (primary) {
+            rLck.lock();
+        }
+        while (me->m_running) {
+            socketType newSocketD = 
+            #ifndef WIN32
+            0;
+            #else
+            INVALID_SOCKET;
+            #endif
+            struct addrinfo* clientAddress;
+            socklen_t addr_size = sizeof clientAddress;
+            #ifndef WIN32
+            if (!poll(pfds, num_listeners, 1000)) {
+            #else
+            if (!WSAPoll(pfds, 1,1000)) {
+            #endif
+                continue;
+            }
+            if (!me->m_running) {
+                break;
+            }
+            #ifndef WIN32
+            if (num_listeners == 2 && (pfds[1].revents & POLLIN)) {
+                newSocketD = accept(me->m_unixSocketD, 0, 0);
+            } else {
+                newSocketD = accept(listener, (struct sockaddr *)&clientAddress, &addr_size);
+            }
+            if (newSocketD == -1) {
+                // out of descriptors or the client gave up before being accepted, neither should stop accepting
+                if (me->m_running) {
+                    me->log("bad socket accepted, error: " + std::string(strerror(errno)));
+                }
+                continue;
+            }
+            #else
+            newSocketD = accept(listener, 0, 0);
+            if (newSocketD == INVALID_SOCKET) {
+                if (me->m_running) {
+                    closesocket(newSocketD);
+                    WSACleanup();
+                    me->log("bad socket accepted, error: " + std::string(strerror(errno)));
+                    throw ManagerStateException("bad socket accepted");
+                } else {
+                    closesocket(newSocketD);
+                    WSACleanup();
+                    continue;
+                }
+            }
+            #endif
+
+            me->queue_handshake(newSocketD);
+        }
+        me->m_running = false;
+    }
+    me->m_runCv.notify_all();
+}
+
+#ifdef UML_SERVER_IO_URING
+struct UmlServer::IoUringLoop {
+    // client being read from, inbound holds what was read that does not make up a whole frame yet
+    struct Connection {
+        ID id = ID::nullID();
+        socketType socket = -1;
+        int buffer_index = -1; // registered buffer reads land in, -1 reads into overflow_buffer instead
+        std::vector<char> overflow_buffer;
+        std::string inbound;
+    };
+    struct io_uring ring;
+    std::vector<char> buffers; // UML_SERVER_IO_URING_BUFFERS buffers registered with the ring
+    std::vector<int> free_buffers;
+    std::unordered_map<std::uint64_t, Connection> connections; // by the user data of their reads
+    std::uint64_t next_connection = 3; // 0 and 1 are the user data of the tcp and unix accepts, 2 of the wake read
+
+    // clients done with their handshake, the handshake thread hands them over and wakes the ring through wake_fd
+    int wake_fd = -1;
+    std::uint64_t wake_count = 0;
+    std::list<std::pair<ID, socketType>> admitted;
+    std::mutex admittedMtx;
+    void admit(ID client_id, socketType socket) {
+        std::lock_guard<std::mutex> admittedLck(admittedMtx);
+        admitted.emplace_back(client_id, socket);
+    }
+
+    // frames going out on one socket, one send is in flight per socket so frames keep their order, whatever
+    // is queued meanwhile goes out together in the next send
+    struct Outbound {
+        std::string pending;
+        std::string in_flight; // bytes of the send in flight when it does not go through a registered buffer
+        int buffer_index = -1; // registered buffer of the send in flight, -1 sends in_flight instead
+        std::size_t in_flight_offset = 0;
+        std::size_t in_flight_size = 0;
+        bool sending = false;
+        bool closed = false; // the client is gone, dropped once the send in flight completes
+    };
+    std::unordered_map<socketType, Outbound> outbound;
+    std::vector<int> free_send_buffers; // UML_SERVER_IO_URING_SEND_BUFFERS registered after the read buffers
+    std::size_t sends_in_flight = 0;
+
+    // replies and notifications from the workers, handed over through wake_fd like admitted clients
+    std::list<std::pair<socketType, std::string>> queued_sends;
+    std::mutex sendsMtx;
+    // return - true if nothing was queued, the ring needs waking then, otherwise it takes this along with the rest
+    bool send(socketType socket, std::string& msg) {
+        std::string frame;
+        frame.reserve(sizeof(uint64_t) + msg.size());
+        uint64_t frame_size = htobe64(msg.size());
+        frame.append(reinterpret_cast<const char*>(&frame_size), sizeof(uint64_t));
+        frame += msg;
+        std::lock_guard<std::mutex> sendsLck(sendsMtx);
+        bool was_empty = queued_sends.empty();
+        queued_sends.emplace_back(socket, std::move(frame));
+        return was_empty;
+    }
+};
+
+void UmlServer::wake_io_uring() {
+    std::uint64_t wake_value = 1;
+    if (write(m_ioUring->wake_fd, &wake_value, sizeof wake_value) < 0) {
+        log("could not wake io_uring loop, error: " + std::string(strerror(errno)));
+    }
+}
+
+void UmlServer::ioUringLoop(UmlServer* me) {
+    // accepts are multishot and reads and sends for every client go through the ring, everything queued while
+    // going over one batch of completions is submitted together with a single syscall
+    static constexpr std::uint64_t TCP_ACCEPT = 0;
+    static constexpr std::uint64_t UNIX_ACCEPT = 1;
+    static constexpr std::uint64_t WAKE = 2;
+    static constexpr std::uint64_t SEND = 1ull << 63; // or'd with the socket for the user data of sends
+    IoUringLoop& loop = *me->m_ioUring;
+    auto get_sqe = [&loop]() {
+        struct io_uring_sqe* sqe = io_uring_get_sqe(&loop.ring);
+        if (!sqe) {
+            // submission queue is full, flush it and take a fresh entry
+            io_uring_submit(&loop.ring);
+            sqe = io_uring_get_sqe(&loop.ring);
+        }
+        return sqe;
+    };
+    auto queue_accept = [&](std::uint64_t listener) {
+        struct io_uring_sqe* sqe = get_sqe();
+        io_uring_prep_multishot_accept(sqe, listener == TCP_ACCEPT ? me->m_socketD : me->m_unixSocketD, 0, 0, 0);
+        io_uring_sqe_set_data64(sqe, listener);
+    };
+    auto queue_read = [&](std::uint64_t key, IoUringLoop::Connection& connection) {
+        struct io_uring_sqe* sqe = get_sqe();
+        if (connection.buffer_index >= 0) {
+            io_uring_prep_read_fixed(sqe, connection.socket, loop.buffers.data() + connection.buffer_index * UML_SERVER_IO_URING_BUFFER_SIZE, UML_SERVER_IO_URING_BUFFER_SIZE, 0, connection.buffer_index);
+        } else {
+            io_uring_prep_recv(sqe, connection.socket, connection.overflow_buffer.data(), UML_SERVER_IO_URING_BUFFER_SIZE, 0);
+        }
+        io_uring_sqe_set_data64(sqe, key);
+    };
+    auto queue_wake = [&]() {
+        struct io_uring_sqe* sqe = get_sqe();
+        io_uring_prep_read(sqe, loop.wake_fd, &loop.wake_count, sizeof loop.wake_count, 0);
+        io_uring_sqe_set_data64(sqe, WAKE);
+    };
+    auto queue_send = [&](socketType socket, IoUringLoop::Outbound& out) {
+        struct io_uring_sqe* sqe = get_sqe();
+        std::size_t remaining = out.in_flight_size - out.in_flight_offset;
+        if (out.buffer_index >= 0) {
+            char* send_buffer = loop.buffers.data() + out.buffer_index * UML_SERVER_IO_URING_BUFFER_SIZE;
+            io_uring_prep_write_fixed(sqe, socket, send_buffer + out.in_flight_offset, remaining, 0, out.buffer_index);
+        } else {
+            io_uring_prep_send(sqe, socket, out.in_flight.data() + out.in_flight_offset, remaining, MSG_NOSIGNAL);
+        }
+        io_uring_sqe_set_data64(sqe, SEND | static_cast<std::uint64_t>(socket));
+    };
+    auto start_send = [&](socketType socket, IoUringLoop::Outbound& out) {
+        // everything pending goes in one send, copied into a registered buffer if it fits in one that is free
+        out.in_flight_offset = 0;
+        if (out.pending.size() <= UML_SERVER_IO_URING_BUFFER_SIZE && !loop.free_send_buffers.empty()) {
+            out.buffer_index = loop.free_send_buffers.back();
+            loop.free_send_buffers.pop_back();
+            memcpy(loop.buffers.data() + out.buffer_index * UML_SERVER_IO_URING_BUFFER_SIZE, out.pending.data(), out.pending.size());
+            out.in_flight_size = out.pending.size();
+            out.pending.clear();
+        } else {
+            out.buffer_index = -1;
+            out.in_flight.swap(out.pending);
+            out.pending.clear();
+            out.in_flight_size = out.in_flight.size();
+        }
+        out.sending = true;
+        loop.sends_in_flight++;
+        queue_send(socket, out);
+    };
+    auto take_sends = [&]() {
+        std::list<std::pair<socketType, std::string>> queued;
+        {
+            std::lock_guard<std::mutex> sendsLck(loop.sendsMtx);
+            queued.swap(loop.queued_sends);
+        }
+        // queue every frame first so frames for the same socket share a send
+        std::vector<socketType> idle_sockets;
+        for (auto& queued_pair : queued) {
+            IoUringLoop::Outbound& out = loop.outbound[queued_pair.first];
+            if (!out.sending && out.pending.empty()) {
+                idle_sockets.push_back(queued_pair.first);
+            }
+            out.pending += queued_pair.second;
+        }
+        for (socketType socket : idle_sockets) {
+            start_send(socket, loop.outbound.at(socket));
+        }
+    };
+    auto complete_send = [&](struct io_uring_cqe* cqe) {
+        socketType socket = static_cast<socketType>(io_uring_cqe_get_data64(cqe) & ~SEND);
+        auto out_match = loop.outbound.find(socket);
+        if (out_match == loop.outbound.end()) {
+            return;
+        }
+        IoUringLoop::Outbound& out = out_match->second;
+        if (cqe->res > 0 && !out.closed && out.in_flight_offset + cqe->res < out.in_flight_size) {
+            // the rest of a partial send goes out before anything queued after it
+            out.in_flight_offset += cqe->res;
+            queue_send(socket, out);
+            return;
+        }
+        loop.sends_in_flight--;
+        out.sending = false;
+        if (out.buffer_index >= 0) {
+            loop.free_send_buffers.push_back(out.buffer_index);
+            out.buffer_index = -1;
+        }
+        out.in_flight.clear();
+        if (cqe->res <= 0 || out.closed) {
+            if (cqe->res < 0 && !out.closed) {
+                me->log("could not send to client socket, error: " + std::string(strerror(-cqe->res)));
+            }
+            loop.outbound.erase(out_match);
+            return;
+        }
+        if (!out.pending.empty()) {
+            start_send(socket, out);
+        }
+    };
+
+    {
+        std::lock_guard<std::mutex> rLck(me->m_runMtx);
+        queue_accept(TCP_ACCEPT);
+        if (me->m_unixSocketD != -1) {
+            queue_accept(UNIX_ACCEPT);
+        }
+        queue_wake();
+        bool accepting_on_thread = false;
+        while (me->m_running) {
+            int status = io_uring_submit_and_wait(&loop.ring, 1);
+            if (status < 0 && status != -EINTR) {
+                me->log("io_uring wait failed, error: " + std::string(strerror(-status)));
+                break;
+            }
+            struct io_uring_cqe* cqe;
+            unsigned head;
+            unsigned num_completions = 0;
+            io_uring_for_each_cqe(&loop.ring, head, cqe) {
+                num_completions++;
+                std::uint64_t key = io_uring_cqe_get_data64(cqe);
+                if (key & SEND) {
+                    complete_send(cqe);
+                    continue;
+                }
+                if (key == TCP_ACCEPT || key == UNIX_ACCEPT) {
+                    if (cqe->res == -EINVAL) {
+                        // multishot accept needs linux 5.19, accept on a thread like without io_uring and keep
+                        // reading and sending through the ring, the thread takes both listeners
+                        if (!accepting_on_thread) {
+                            me->log("multishot accept is not supported by this kernel, accepting new clients on a thread instead");
+                            accepting_on_thread = true;
+                            me->m_reusePortThreads.push_back(new std::thread(acceptNewClients, me, me->m_socketD, false));
+                        }
+                        continue;
+                    }
+                    if (!(cqe->flags & IORING_CQE_F_MORE) && me->m_running) {
+                        // the kernel stopped the multishot accept, start it again
+                        queue_accept(key);
+                    }
+                    if (cqe->res < 0) {
+                        if (me->m_running) {
+                            me->log("bad socket accepted, error: " + std::string(strerror(-cqe->res)));
+                        }
+                        continue;
+                    }
+                    me->queue_handshake(cqe->res);
+                    continue;
+                }
+                if (key == WAKE) {
+                    // start reading from the clients whose handshake finished
+                    std::list<std::pair<ID, socketType>> admitted;
+                    {
+                        std::lock_guard<std::mutex> admittedLck(loop.admittedMtx);
+                        admitted.swap(loop.admitted);
+                    }
+                    for (auto& admitted_pair : admitted) {
+                        // whatever is left for a socket of a client that went away is not for this one
+                        auto stale_match = loop.outbound.find(admitted_pair.second);
+                        if (stale_match != loop.outbound.end() && !stale_match->second.sending) {
+                            loop.outbound.erase(stale_match);
+                        }
+                        std::uint64_t connection_key = loop.next_connection++;
+                        IoUringLoop::Connection& connection = loop.connections[connection_key];
+                        connection.id = admitted_pair.first;
+                        connection.socket = admitted_pair.second;
+                        if (!loop.free_buffers.empty()) {
+                            connection.buffer_index = loop.free_buffers.back();
+                            loop.free_buffers.pop_back();
+                        } else {
+                            connection.overflow_buffer.resize(UML_SERVER_IO_URING_BUFFER_SIZE);
+                        }
+                        queue_read(connection_key, connection);
+                    }
+                    take_sends();
+                    if (me->m_running) {
+                        queue_wake();
+                    }
+                    continue;
+                }
+
+                auto connection_match = loop.connections.find(key);
+                if (connection_match == loop.connections.end()) {
+                    continue;
+                }
+                IoUringLoop::Connection& connection = connection_match->second;
+                if (cqe->res <= 0) {
+                    me->log(std::format("ERROR: fatal client error for client {}", connection.id.string()));
+                    me->queue_zombie(connection.id);
+                    if (connection.buffer_index >= 0) {
+                        loop.free_buffers.push_back(connection.buffer_index);
+                    }
+                    auto out_match = loop.outbound.find(connection.socket);
+                    if (out_match != loop.outbound.end()) {
+                        if (out_match->second.sending) {
+                            out_match->second.closed = true;
+                        } else {
+                            loop.outbound.erase(out_match);
+                        }
+                    }
+                    loop.connections.erase(connection_match);
+                    continue;
+                }
+                const char* read_buffer = connection.buffer_index >= 0 ? loop.buffers.data() + connection.buffer_index * UML_SERVER_IO_URING_BUFFER_SIZE : connection.overflow_buffer.data();
+                connection.inbound.append(read_buffer, cqe->res);
+
+                // dispatch every whole frame read, a client can send many requests before reading a reply
+                std::size_t frame_start = 0;
+                while (connection.inbound.size() - frame_start >= sizeof(uint64_t)) {
+                    uint64_t frame_size;
+                    memcpy(&frame_size, connection.inbound.data() + frame_start, sizeof(uint64_t));
+                    frame_size = be64toh(frame_size);
+                    if (connection.inbound.size() - frame_start - sizeof(uint64_t) < frame_size) {
+                        break;
+                    }
+                    me->queue_request(connection.id, connection.inbound.substr(frame_start + sizeof(uint64_t), frame_size));
+                    frame_start += sizeof(uint64_t) + frame_size;
+                }
+                connection.inbound.erase(0, frame_start);
+                queue_read(key, connection);
+            }
+            io_uring_cq_advance(&loop.ring, num_completions);
+        }
+
+        // what was queued before the server stopped still goes out, the reply to KILL among it, clients not taking
+        // it within the handshake timeout don't hold shutting down up
+        take_sends();
+        auto flush_deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(UML_SERVER_HANDSHAKE_TIMEOUT);
+        while (loop.sends_in_flight && std::chrono::steady_clock::now() < flush_deadline) {
+            struct __kernel_timespec flush_timeout = { 0, 100 * 1000 * 1000 };
+            struct io_uring_cqe* cqe;
+            io_uring_submit_and_wait_timeout(&loop.ring, &cqe, 1, &flush_timeout, 0);
+            unsigned head;
+            unsigned num_completions = 0;
+            io_uring_for_each_cqe(&loop.ring, head, cqe) {
+                num_completions++;
+                if (io_uring_cqe_get_data64(cqe) & SEND) {
+                    complete_send(cqe);
+                }
+            }
+            io_uring_cq_advance(&loop.ring, num_completions);
+            take_sends();
+        }
+        me->m_running = false;
+    }
+    me->m_runCv.notify_all();
+}
+#endif
+
+static void set_blocking(socketType socket, bool blocking) {
+    #ifndef WIN32
+    int flags = fcntl(socket, F_GETFL, 0);
+    fcntl(socket, F_SETFL, blocking ? flags & ~O_NONBLOCK : flags | O_NONBLOCK);
+    #else
+    u_long non_blocking = blocking ? 0 : 1;
+    ioctlsocket(socket, FIONBIO, &non_blocking);
+    #endif
+}
+
+static bool would_block() {
+    #ifndef WIN32
+    return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+    #else
+    return WSAGetLastError() == WSAEWOULDBLOCK;
+    #endif
+}
+
+static void close_socket(socketType socket) {
+    #ifndef WIN32
+    close(socket);
+    #else
+    closesocket(socket);
+    #endif
+}
+
+void UmlServer::queue_handshake(socketType newSocketD) {
+    {
+        std::lock_guard<std::mutex> handshakeLck(m_handshakeMtx);
+        m_newConnections.push_back(newSocketD);
+    }
+    wake_handshakes();
+}
+
+void UmlServer::wake_handshakes() {
+    #ifndef WIN32
+    char wake_byte = 0;
+    if (write(m_handshakeWake[1], &wake_byte, 1) < 0) {
+        // pipe is full so the thread is getting woken up anyway
+    }
+    #endif
+}
+
+void UmlServer::handshakeClients(UmlServer* me) {
+    // a client hanging up mid handshake should not take the server down with SIGPIPE
+    #ifdef MSG_NOSIGNAL
+    static constexpr int HANDSHAKE_SEND_FLAGS = MSG_NOSIGNAL;
+    #else
+    static constexpr int HANDSHAKE_SEND_FLAGS = 0;
+    #endif
+    // the server sends the list of meta managers, then the client answers with its id framed like any message
+    struct PendingHandshake {
+        socketType socket;
+        std::string outbound;
+        std::size_t sent = 0;
+        char inbound[sizeof(uint64_t) + 28];
+        std::size_t received = 0;
+        std::chrono::steady_clock::time_point deadline;
+    };
+    std::list<PendingHandshake> pending;
+    std::vector<struct pollfd> pfds;
+    while (me->m_running) {
+        // take on the sockets accepted since last time around
+        std::list<socketType> new_connections;
+        {
+            std::lock_guard<std::mutex> handshakeLck(me->m_handshakeMtx);
+            new_connections.swap(me->m_newConnections);
+        }
+        for (socketType new_socket : new_connections) {
+            set_blocking(new_socket, false);
+            PendingHandshake& handshake = pending.emplace_back();
+            handshake.socket = new_socket;
+            std::string meta_managers = me->meta_manager_list();
+            uint64_t meta_managers_size = htobe64(meta_managers.size());
+            handshake.outbound.append((const char*) &meta_managers_size, sizeof(uint64_t));
+            handshake.outbound += meta_managers;
+            handshake.deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(me->m_handshakeTimeout);
+        }
+
+        // wait on every socket for whichever way its handshake is going, but no longer than the nearest deadline
+        pfds.clear();
+        #ifndef WIN32
+        pfds.push_back({me->m_handshakeWake[0], POLLIN, 0});
+        int timeout = 1000;
+        #else
+        // nothing to wake the thread on windows so new connections are picked up on the next timeout
+        int timeout = 10;
+        #endif
+        std::size_t first_handshake_pfd = pfds.size();
+        auto now = std::chrono::steady_clock::now();
+        for (auto& handshake : pending) {
+            pfds.push_back({handshake.socket, static_cast<short>(handshake.sent < handshake.outbound.size() ? POLLOUT : POLLIN), 0});
+            auto until_deadline = std::chrono::duration_cast<std::chrono::milliseconds>(handshake.deadline - now).count();
+            timeout = std::max(0, std::min(timeout, static_cast<int>(until_deadline)));
+        }
+        #ifndef WIN32
+        if (poll(pfds.data(), pfds.size(), timeout) < 0 && errno != EINTR) {
+        #else
+        if (!pfds.empty() && WSAPoll(pfds.data(), pfds.size(), timeout) == SOCKET_ERROR) {
+        #endif
+            me->log("handshake poll failed, error: " + std::string(strerror(errno)));
+        }
+        #ifdef WIN32
+        if (pfds.empty()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(timeout));
+        }
+        #else
+        if (pfds[0].revents & POLLIN) {
+            char wake_buffer[64];
+            while (read(me->m_handshakeWake[0], wake_buffer, sizeof wake_buffer) > 0) {}
+        }
+        #endif
+
+        // move every handshake along as far as its socket lets it
+        now = std::chrono::steady_clock::now();
+        std::size_t pfd_index = first_handshake_pfd;
+        for (auto handshake_it = pending.begin(); handshake_it != pending.end(); pfd_index++) {
+            PendingHandshake& handshake = *handshake_it;
+            bool ready = pfd_index < pfds.size() && pfds[pfd_index].revents;
+            std::string failure;
+            bool done = false;
+            if (ready && handshake.sent < handshake.outbound.size()) {
+                auto bytes_sent = send(handshake.socket, handshake.outbound.data() + handshake.sent, handshake.outbound.size() - handshake.sent, HANDSHAKE_SEND_FLAGS);
+                if (bytes_sent > 0) {
+                    handshake.sent += bytes_sent;
+                } else if (!would_block()) {
+                    failure = "could not send meta managers";
+                }
+            } else if (ready) {
+                auto bytes_received = recv(handshake.socket, handshake.inbound + handshake.received, sizeof handshake.inbound - handshake.received, 0);
+                if (bytes_received > 0) {
+                    handshake.received += bytes_received;
+                    uint64_t id_size;
+                    memcpy(&id_size, handshake.inbound, sizeof(uint64_t));
+                    if (handshake.received >= sizeof(uint64_t) && be64toh(id_size) != 28) {
+                        failure = "reported improper size for its id";
+                    } else if (handshake.received == sizeof handshake.inbound) {
+                        done = true;
+                    }
+                } else if (bytes_received == 0 || !would_block()) {
+                    failure = "closed the connection";
+                }
+            }
+            std::string id_string;
+            if (done) {
+                id_string = std::string(handshake.inbound + sizeof(uint64_t), 28);
+                if (!ID::isValid(id_string)) {
+                    failure = "sent an invalid id";
+                }
+            }
+            if (failure.empty() && !done && now >= handshake.deadline) {
+                failure = "timed out";
+            }
+            if (!failure.empty()) {
+                me->log("dropped connection during handshake, client " + failure);
+                close_socket(handshake.socket);
+                handshake_it = pending.erase(handshake_it);
+                continue;
+            }
+            if (!done) {
+                handshake_it++;
+                continue;
+            }
+
+            socketType client_socket = handshake.socket;
+            handshake_it = pending.erase(handshake_it);
+            ID client_id = ID::fromString(id_string);
+            if (client_id == me->m_shutdownID) {
+                close_socket(client_socket);
+                me->m_running = false;
+                #ifdef UML_SERVER_IO_URING
+                me->wake_io_uring();
+                #endif
+                break;
+            }
+            set_blocking(client_socket, true);
+            std::lock_guard<std::mutex> aLck(me->m_acceptMtx);
+            me->log("server aquired acceptance lock");
+            try {
+                admitClient(me, client_socket, client_id);
+            } catch (std::exception& e) {
+                me->log("could not send id back to client " + client_id.string() + ": " + e.what());
+            }
+        }
+    }
+
+    // whatever is still mid handshake when the server stops is dropped
+    for (auto& handshake : pending) {
+        close_socket(handshake.socket);
+    }
+    std::lock_guard<std::mutex> handshakeLck(me->m_handshakeMtx);
+    for (socketType new_socket : me->m_newConnections) {
+        close_socket(new_socket);
+    }
+    me->m_newConnections.clear();
+}
+
+void UmlServer::admitClient(UmlServer* me, socketType newSocketD, ID client_id) {
+    // add to client map setup threads, the io_uring loop reads for every client itself
+    me->log("got id from client: " + client_id.string());
+    auto client_info = std::make_shared<ClientInfo>();
+    client_info->socket = newSocketD;
+    client_info->thread = 0;
+    {
+        std::lock_guard<std::mutex> clientsLck(me->m_clientsMtx);
+        me->m_clients[client_id] = client_info;
+    }
+    #ifndef UML_SERVER_IO_URING
+    client_info->thread = new std::thread(receiveFromClient, me, client_id);
+    #endif
+
+    auto id_buffer_string = client_id.string();
+    send_message(newSocketD, id_buffer_string);
+    me->log("sent id back to client: " + client_id.string());
+    #ifdef UML_SERVER_IO_URING
+    me->m_ioUring->admit(client_id, newSocketD);
+    me->wake_io_uring();
+    #endif
+}
+
+std::shared_ptr<UmlServer::ClientInfo> UmlServer::find_client(ID id) {
+    std::lock_guard<std::mutex> clientsLck(m_clientsMtx);
+    auto client_match = m_clients.find(id);
+    if (client_match == m_clients.end()) {
+        return 0;
+    }
+    return client_match->second;
+}
+
+void UmlServer::queue_request(ID id, std::string message) {
+    auto client = find_client(id);
+    if (!client) {
+        return;
+    }
+    ClientInfo& info = *client;
+    {
+        std::lock_guard<std::mutex> lck(info.handlerMtx);
+        if (info.closed) {
+            return;
+        }
+        info.threadQueue.push_back(std::move(message));
+        if (info.scheduled) {
+            return;
+        }
+        info.scheduled = true;
+    }
+    m_workers.submit([this, id]() { serveClient(id); });
+}
+
+void UmlServer::serveClient(ID id) {
+    // handle the next request of the client, then go back in the pool behind everyone else so a client sending a
+    // lot never holds up the rest. The client stays scheduled until its queue is empty so its requests never overlap
+    auto client = find_client(id);
+    if (!client) {
+        return;
+    }
+    ClientInfo& info = *client;
+    std::string buff;
+    {
+        std::lock_guard<std::mutex> lck(info.handlerMtx);
+        if (info.threadQueue.empty() || info.closed) {
+            info.scheduled = false;
+            info.handlerCv.notify_all();
+            return;
+        }
+        buff = std::move(info.threadQueue.front());
+        info.threadQueue.pop_front();
+        info.serving = std::this_thread::get_id();
+    }
+    try {
+        handleMessage(id, buff);
+    } catch (std::exception& e) {
+        log("ERROR handling message from client " + id.string() + ": " + e.what());
+    }
+    {
+        std::lock_guard<std::mutex> lck(info.handlerMtx);
+        info.serving = std::thread::id();
+    }
+    m_workers.submit([this, id]() { serveClient(id); });
+}
+
+void UmlServer::clientSender(UmlServer* me, ID id) {
+    auto client = me->find_client(id);
+    if (!client) {
+        return;
+    }
+    ClientInfo& info = *client;
+    std::list<std::string> to_send;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> outboundLck(info.outboundMtx);
+            info.outboundCv.wait(outboundLck, [&info] { return !info.outbound.empty() || info.closing; });
+            if (info.outbound.empty()) {
+                return;
+            }
+            to_send.swap(info.outbound);
+        }
+        try {
+            for (auto& notification : to_send) {
+                me->reply(info, notification);
             }
         } catch (std::exception& e) {
-            log("ERROR saving element, error: " + std::string(e.what()));
-            std::string error_message = std::format(
-                    "{{\"error\":\"error saving element: {}\"}}",
-                    e.what()    
-                );
-            send_message(info.socket, error_message);
-            return;
+            me->log("could not send notification to client " + id.string() + ": " + e.what());
         }
-        log("saved element to " + path);
-        std::string reply_message = "{\"status\":\"success\"}";
-        log(reply_message);
-        send_message(info.socket, reply_message);
-    } else {
-        log("ERROR receiving message from client, invalid format!\nMessage:\n" + buff);
-        std::string msg = "{\"error\":\"ERROR receiving message from client, invalid format!\"}";
-        send_message(info.socket, msg);
-        return;
+        to_send.clear();
     }
-    log("Done processing message");
 }
 
-void UmlServer::receiveFromClient(UmlServer* me, ID id) {
+std::string UmlServer::emit_meta_manager_list() {
+    YAML::Emitter emitter;
+    emitter << YAML::DoubleQuoted << YAML::Flow; // emit json
+
+    // info to give is just the present metaManagers in a list
+    emitter << YAML::BeginSeq;
+    for (auto& meta_manager_pair : meta_managers()) {
+        emitter << YAML::BeginMap;
+        emitter << YAML::Key << "id";
+        emitter << YAML::Value << meta_manager_pair.first.string();
+        emitter << YAML::Key << "uml_root";
+        emitter << YAML::Value << meta_manager_pair.second.get_generation_root().id().string();
+        emitter << YAML::EndMap;
+    }
+    emitter << YAML::EndSeq;
+    return emitter.c_str();
+}
 
-    /**
-     * TODO: lossless receive, client can rapidfire messages
-     **/
+void UmlServer::refresh_meta_manager_list() {
+    // meta managers are never taken away so the list only changes when there are more of them
+    if (meta_managers().size() == m_metaManagerListSize) {
+        return;
+    }
+    std::string list = emit_meta_manager_list();
+    m_metaManagerListSize = meta_managers().size();
+    std::lock_guard<std::mutex> listLck(m_metaManagerListMtx);
+    m_metaManagerList = std::move(list);
+}
 
-    me->log("server set up thread to listen to client " + id.string());
-    ClientInfo& info = me->m_clients[id];
-    while (me->m_running) {
-        // receive message
-        auto message_option = receive_message(info.socket);
-        if (!message_option) {
-            me->log(std::format("ERROR: fatal client error for client {}", id.string()));
-            return;
-        }
+std::string UmlServer::meta_manager_list() {
+    std::lock_guard<std::mutex> listLck(m_metaManagerListMtx);
+    return m_metaManagerList;
+}
 
-        // dispatch message
-        std::lock_guard<std::mutex> lck(info.handlerMtx);
-        info.threadQueue.push_back(*message_option);
-        me->log("receive from client thread added new message to threadQueue");
-        info.handlerCv.notify_one();
+void UmlServer::reply(ClientInfo& info, std::string& msg, std::optional<std::uint64_t> request_id) {
+    std::string tagged_msg;
+    std::string& sent_msg = request_id ? (tagged_msg = std::format("{{\"rid\":{},\"reply\":{}}}", *request_id, msg)) : msg;
+    std::lock_guard<std::mutex> sendLck(info.sendMtx);
+    #ifdef __linux__
+    // a memfd sent straight to the socket could pass frames the ring has not sent yet, or land in the middle of
+    // one it sent in part, so with the ring everything goes through it the ordinary way
+    bool ring_sends = false;
+    #ifdef UML_SERVER_IO_URING
+    ring_sends = m_ioUring != 0;
+    #endif
+    if (info.shared_memory && !ring_sends && sent_msg.size() >= UML_SERVER_SHARED_MEMORY_MIN && send_shared_message(info.socket, sent_msg)) {
+        return;
+    }
+    #endif
+    #ifdef UML_SERVER_IO_URING
+    // the ring sends it along with everything else going out, without blocking this worker
+    if (m_ioUring) {
+        if (m_ioUring->send(info.socket, sent_msg)) {
+            wake_io_uring();
+        }
+        return;
     }
+    #endif
+    send_message(info.socket, sent_msg);
 }
 
-void UmlServer::acceptNewClients(UmlServer* me) {
-    struct pollfd pfds[1] = {{me->m_socketD, POLLIN}};
-    {
-        std::lock_guard<std::mutex> rLck(me->m_runMtx);
-        while (me->m_running) {
-            socketType newSocketD = 
-            #ifndef WIN32
-            0;
-            #else
-            INVALID_SOCKET;
-            #endif
-            struct addrinfo* clientAddress;
-            socklen_t addr_size = sizeof clientAddress;
-            #ifndef WIN32
-            if (!poll(pfds, 1, 1000)) {
-            #else
-            if (!WSAPoll(pfds, 1,1000)) {
-            #endif
-                continue;
+void UmlServer::notify_change(ID source_client, ID changed_id, std::size_t element_type, std::string kind, AbstractElement* el) {
+    // deleted elements keep a version too so copies clients kept of them are stale
+    std::uint64_t version = ++m_version_clock;
+    m_versions[changed_id] = version;
+
+    // build each form of the message once no matter how many clients get it
+    std::string notification;
+    std::string notification_with_body;
+    std::string invalidation;
+    auto notify = [&](ClientInfo& client, ID subscriber_id, ClientSubscriptions& subscriptions, bool shares_connection) {
+        if (subscriber_id == source_client || subscriptions.empty()) {
+            return;
+        }
+        std::vector<std::string*> msgs;
+
+        // the client is tracked again when it gets the element next
+        if (subscriptions.cached.erase(changed_id)) {
+            if (invalidation.empty()) {
+                invalidation = std::format("{{\"invalidate\":\"{}\",\"version\":{}}}", changed_id.string(), version);
             }
-            if (!me->m_running) {
-                break;
+            msgs.push_back(&invalidation);
+        }
+
+        bool subscribed = subscriptions.elements.contains(changed_id) || subscriptions.types.contains(element_type);
+        for (auto it = subscriptions.subtrees.begin(); !subscribed && it != subscriptions.subtrees.end(); it++) {
+            subscribed = *it == changed_id || m_qualified_names.owned_by(changed_id, *it);
+        }
+        if (subscribed && subscriptions.bodies && el) {
+            if (notification_with_body.empty()) {
+                notification_with_body = std::format(
+                        "{{\"notification\":{{\"kind\":\"{}\",\"id\":\"{}\",\"type\":\"{}\",\"body\":{}}}}}",
+                        kind,
+                        changed_id.string(),
+                        element_types_to_name.at(element_type),
+                        this->emitIndividual(*el)
+                    );
             }
-            std::lock_guard<std::mutex> aLck(me->m_acceptMtx);
-            me->log("server aquired acceptance lock");
-            #ifndef WIN32
-            newSocketD = accept(me->m_socketD, (struct sockaddr *)&clientAddress, &addr_size);
-            if (newSocketD == -1) {
-                if (me->m_running) {
-                    me->log("bad socket accepted, error: " + std::string(strerror(errno)));
-                    throw ManagerStateException("bad socket accepted");
-                } else {
-                    continue;
-                }
+            msgs.push_back(&notification_with_body);
+        } else if (subscribed) {
+            if (notification.empty()) {
+                notification = std::format(
+                        "{{\"notification\":{{\"kind\":\"{}\",\"id\":\"{}\",\"type\":\"{}\"}}}}",
+                        kind,
+                        changed_id.string(),
+                        element_types_to_name.at(element_type)
+                    );
             }
-            #else
-            newSocketD = accept(me->m_socketD, 0, 0);
-            if (newSocketD == INVALID_SOCKET) {
-                if (me->m_running) {
-                    closesocket(newSocketD);
-                    WSACleanup();
-                    me->log("bad socket accepted, error: " + std::string(strerror(errno)));
-                    throw ManagerStateException("bad socket accepted");
+            msgs.push_back(&notification);
+        }
+        if (msgs.empty()) {
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> outboundLck(client.outboundMtx);
+            for (auto msg : msgs) {
+                if (shares_connection) {
+                    // say which of the clients on the connection it is for
+                    client.outbound.push_back(std::format("{{\"to\":\"{}\",\"message\":{}}}", subscriber_id.string(), *msg));
                 } else {
-                    closesocket(newSocketD);
-                    WSACleanup();
-                    continue;
+                    client.outbound.push_back(*msg);
                 }
             }
-            #endif
-           
-            YAML::Emitter emitter;
-            emitter << YAML::DoubleQuoted << YAML::Flow; // emit json
-
-            // info to give is just the present metaManagers in a list
-            emitter << YAML::BeginSeq;
-            for (auto& meta_manager_pair : me->meta_managers()) {
-                emitter << YAML::BeginMap;
-                emitter << YAML::Key << "id";
-                emitter << YAML::Value << meta_manager_pair.first.string();
-                emitter << YAML::Key << "uml_root";
-                emitter << YAML::Value << meta_manager_pair.second.get_generation_root().id().string();
-                emitter << YAML::EndMap;
-            }
-            emitter << YAML::EndSeq;
-
-            // send to client
-            std::string json_dump = emitter.c_str();
-            send_message(newSocketD, json_dump);
+        }
+        client.outboundCv.notify_one();
+    };
+
+    // clients admitted meanwhile wait, they have no subscriptions yet anyway
+    std::lock_guard<std::mutex> clientsLck(m_clientsMtx);
+    for (auto& client_pair : m_clients) {
+        ClientInfo& client = *client_pair.second;
+        notify(client, client_pair.first, client.subscriptions, false);
+        for (auto& attached_pair : client.attached_clients) {
+            notify(client, attached_pair.first, attached_pair.second, true);
+        }
+    }
+}
 
-            // client will send back an id
-            uint64_t size_buffer;
-            int bytes_received =  recv(newSocketD, &size_buffer, sizeof(uint64_t), 0);
-            if (bytes_received != sizeof(uint64_t)) {
-                throw ManagerStateException("Did not read full uint64_t size");
+void UmlServer::garbageCollector(UmlServer* me) {
+    while(me->m_running) {
+        bool evict = false;
+        {
+            // also wake up on a timer, uml mirrors go stale without anything being queued
+            std::unique_lock<std::mutex> garbageLck(me->m_garbageMtx);
+            bool queue_changed = me->m_garbageCv.wait_for(garbageLck, std::chrono::milliseconds(UML_SERVER_SYNC_INTERVAL), [me] { 
+                return me->m_releaseQueue.size() != me->m_numEls; 
+            });
+            if (queue_changed && me->m_numEls == me->m_maxEls) {
+                evict = true;
+            } else if (queue_changed) {
+                me->m_numEls++;
             }
+        }
 
-            size_buffer = be64toh(size_buffer);
-
-            if (size_buffer != 28) {
-                throw ManagerStateException("Clients reported message size for id is of improper size!");
+        if (evict) {
+            // releasing changes the managers so no request may be running meanwhile, the handler lock is taken
+            // before the garbage lock like requests queueing what they load do
+            std::unique_lock<std::shared_mutex> handlerLck(me->m_messageHandlerMtx);
+            std::lock_guard<std::mutex> garbageLck(me->m_garbageMtx);
+            if (me->m_numEls == me->m_maxEls && !me->m_releaseQueue.empty()) {
+                ResidentElement released = me->m_releaseQueue.back();
+                // an element released or erased since it was queued has nothing to give back
+                if (released.manager == ID::nullID()) {
+                    if (me->loaded(released.id)) {
+                        me->release(*me->get(released.id));
+                    }
+                } else if (me->meta_managers().count(released.manager)) {
+                    me->get_meta_manager(released.manager).release_resident(released.id);
+                }
+                me->m_releaseQueue.pop_back();
             }
+        }
 
-            char id_buffer[29];
-            bytes_received = recv(newSocketD, id_buffer, 28, 0);
-            if (bytes_received != 28) {
-                throw ManagerStateException("Did not receive enough bytes from client for id!");
-            }
+        // update uml mirrors of meta elements while no request is being handled, 
+        // never wait on the handler, it may be shutting us down
+        std::unique_lock<std::shared_mutex> handlerLck(me->m_messageHandlerMtx, std::try_to_lock);
+        if (handlerLck.owns_lock() && me->m_running) {
+            me->sync_meta_managers();
+        }
+    }
+}
 
-            id_buffer[28] = '\0';
+std::uint64_t UmlServer::version_of(ID id) const {
+    auto version_match = m_versions.find(id);
+    if (version_match == m_versions.end()) {
+        return 1;
+    }
+    return version_match->second;
+}
 
-            auto client_id = ID::fromString(id_buffer);
+void UmlServer::track_cached(ClientSubscriptions& subscriptions, ID id) {
+    if (subscriptions.cache) {
+        subscriptions.cached.insert(id);
+    }
+}
 
-            if (client_id == me->m_shutdownID)
-                break;
+void UmlServer::queue_resident(ID manager_id, ID element_id) {
+    std::lock_guard<std::mutex> garbageLck(m_garbageMtx);
+    m_releaseQueue.push_front(ResidentElement { manager_id, element_id });
+    m_garbageCv.notify_one();
+}
 
-            // add to client map setup threads
-            me->log("got id from client: " + client_id.string());
-            ClientInfo& client_info = me->m_clients[client_id];
-            client_info.socket = newSocketD;
-            client_info.thread = new std::thread(receiveFromClient, me, client_id);
-            client_info.handler = new std::thread(clientSubThreadHandler, me, client_id);
-           
-            auto id_buffer_string = client_id.string();
-            send_message(newSocketD, id_buffer_string);
-            me->log("sent id back to client: " + client_id.string());
-        }
-        me->m_running = false;
+void UmlServer::queue_new_proxy_elements(MetaManager& meta_manager, ID manager_id) {
+    for (auto& proxy_id : meta_manager.take_new_proxy_elements()) {
+        queue_resident(manager_id, proxy_id);
     }
-    me->m_runCv.notify_all();
 }
 
-void UmlServer::clientSubThreadHandler(UmlServer* me, ID id) {
-    ClientInfo& info = me->m_clients[id];
-    while (me->m_running && info.thread) {
-        std::unique_lock<std::mutex> lck(info.handlerMtx);
-        info.handlerCv.wait(lck, [&info] { return !info.threadQueue.empty(); });
-        for (std::string buff : info.threadQueue) {
-            if (!buff.empty()) {
-                me->handleMessage(id, buff);
-            }
-        }
-        info.threadQueue.clear();
+void UmlServer::unqueue_resident(ID element_id) {
+    std::lock_guard<std::mutex> garbageLck(m_garbageMtx);
+    auto match = std::find_if(m_releaseQueue.begin(), m_releaseQueue.end(), [element_id](ResidentElement& resident) {
+        return resident.id == element_id;
+    });
+    if (match != m_releaseQueue.end()) {
+        m_releaseQueue.erase(match);
+        m_numEls--;
     }
 }
 
-void UmlServer::garbageCollector(UmlServer* me) {
-    while(me->m_running) {
-        std::unique_lock<std::mutex> garbageLck(me->m_garbageMtx);
-        me->m_garbageCv.wait(garbageLck, [me] { return me->m_releaseQueue.size() != me->m_numEls; });
-        if (me->m_numEls == me->m_maxEls) {
-            ID releasedID = me->m_releaseQueue.back();
-            ElementPtr elToErase = me->get(releasedID);
-            me->release(*elToErase);
-            me->m_releaseQueue.pop_back();
-        } else {
-            me->m_numEls++;
+void UmlServer::generationJob(UmlServer* me, ID manager_id) {
+    bool done = false;
+    while (!done && me->m_running) {
+        // never block on the handler lock, it is held while the server shuts down
+        std::unique_lock<std::shared_mutex> handleLock(me->m_messageHandlerMtx, std::try_to_lock);
+        if (!handleLock.owns_lock()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            continue;
+        }
+
+        GenerationJob& job = me->m_generation_jobs.at(manager_id);
+        try {
+            done = me->get_meta_manager(manager_id).discover_types(UML_SERVER_GENERATION_STEP);
+        } catch (std::exception& e) {
+            job.error = e.what();
+            done = true;
         }
+        job.done = done;
+        handleLock.unlock();
+
+        // give requests waiting on the handler a chance between steps
+        std::this_thread::yield();
     }
+    me->log("background generation of manager " + manager_id.string() + " finished");
 }
 
 void UmlServer::closeClientConnections(ClientInfo& client) {
-    client.thread->join();
+    if (client.sender) {
+        {
+            std::lock_guard<std::mutex> outboundLck(client.outboundMtx);
+            client.closing = true;
+        }
+        client.outboundCv.notify_all();
+        client.sender->join();
+        delete client.sender;
+        client.sender = 0;
+    }
+    if (client.thread) {
+        client.thread->join();
+    }
     #ifndef WIN32
     close(client.socket);
     #else
@@ -764,10 +2525,26 @@ void UmlServer::closeClientConnections(ClientInfo& client) {
     #endif
     delete client.thread;
     client.thread = 0;
-    client.threadQueue.push_back("");
-    client.handlerCv.notify_all();
-    client.handler->join();
-    delete client.handler;
+
+    // wait out the request being handled unless it is the one closing us
+    std::unique_lock<std::mutex> handlerLck(client.handlerMtx);
+    client.closed = true;
+    client.threadQueue.clear();
+    if (client.serving != std::this_thread::get_id()) {
+        client.handlerCv.wait(handlerLck, [&client] { return !client.scheduled; });
+    }
+}
+
+void UmlServer::queue_zombie(ID id) {
+    // nothing is removed once the server stops, shutting down closes every client itself
+    if (!m_running) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> zombieLck(m_zombieMtx);
+        m_zombies.push_back(id);
+    }
+    m_zombieCv.notify_one();
 }
 
 void UmlServer::zombieKiller(UmlServer* me) {
@@ -775,9 +2552,17 @@ void UmlServer::zombieKiller(UmlServer* me) {
         std::unique_lock<std::mutex> zombieLck(me->m_zombieMtx);
         me->m_zombieCv.wait(zombieLck, [me] { return !me->m_zombies.empty() || !me->m_running; });
         for (const ID id : me->m_zombies) {
-            ClientInfo& client = me->m_clients[id];
-            me->closeClientConnections(client);
-            me->m_clients.erase(id);
+            std::shared_ptr<ClientInfo> client;
+            {
+                std::lock_guard<std::mutex> clientsLck(me->m_clientsMtx);
+                auto client_match = me->m_clients.find(id);
+                if (client_match == me->m_clients.end()) {
+                    continue;
+                }
+                client = std::move(client_match->second);
+                me->m_clients.erase(client_match);
+            }
+            me->closeClientConnections(*client);
         }
         me->m_zombies.clear();
     }
@@ -858,6 +2643,18 @@ UmlServer::~UmlServer() {
     if (m_running) {
         shutdownServer();
     }
+
+    // a KILL shuts the server down on its own thread, it has to be done before anything goes away
+    std::thread* kill_thread = 0;
+    {
+        std::lock_guard<std::mutex> killLck(m_killMtx);
+        kill_thread = m_killThread;
+        m_killThread = 0;
+    }
+    if (kill_thread) {
+        kill_thread->join();
+        delete kill_thread;
+    }
 }
 
 void UmlServer::start() {
@@ -869,35 +2666,80 @@ void UmlServer::start() {
     hints.ai_family = AF_UNSPEC;     // don't care IPv4 or IPv6
     hints.ai_socktype = SOCK_STREAM; // TCP stream sockets
     hints.ai_flags = AI_PASSIVE; // fill in my IP for me
-    const char* portStr = std::to_string(m_port).c_str();
-    if ((status = getaddrinfo(NULL, portStr, &hints, &m_address)) != 0) {
+    std::string portStr = std::to_string(m_port);
+    if ((status = getaddrinfo(NULL, portStr.c_str(), &hints, &m_address)) != 0) {
         throw ManagerStateException("Server could not get address info! error: " + std::string(strerror(errno)));
     }
 
-    // get socket descriptor
-    if ((m_socketD = socket(m_address->ai_family, m_address->ai_socktype, m_address->ai_protocol)) == -1) {
-        throw ManagerStateException("Server could not get socket from addressinfo, error: " + std::string(strerror(errno)));
-    }
+    #ifdef UML_SERVER_IO_URING
+    // the ring takes every accept itself
+    std::size_t num_listeners = 1;
+    #else
+    std::size_t num_listeners = m_numAcceptThreads;
+    #endif
+    auto open_listener = [&]() {
+        // get socket descriptor
+        socketType listener;
+        if ((listener = socket(m_address->ai_family, m_address->ai_socktype, m_address->ai_protocol)) == -1) {
+            throw ManagerStateException("Server could not get socket from addressinfo, error: " + std::string(strerror(errno)));
+        }
 
-    // allow address reuse
-    int enable_reuse_addr = 1;
-    if (setsockopt(m_socketD, SOL_SOCKET, SO_REUSEADDR, &enable_reuse_addr, sizeof(int)) < 0) {
-        throw ManagerStateException("Server could not set socket options, error: " + std::string(strerror(errno)));
-    }
+        // allow address reuse
+        int enable_reuse_addr = 1;
+        if (setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &enable_reuse_addr, sizeof(int)) < 0) {
+            throw ManagerStateException("Server could not set socket options, error: " + std::string(strerror(errno)));
+        }
 
-    // disable NAGLES algorithm cause we tend to send small bits of data instead of large messages
-    int enable_tcp_nodelay = 1;
-    if (setsockopt(m_socketD, IPPROTO_TCP, TCP_NODELAY, &enable_tcp_nodelay, sizeof(int)) < 0) {
-        throw ManagerStateException("Server could not set socket options, error: " + std::string(strerror(errno)));
-    }
+        // every accept thread listens on its own socket bound to the same port, the kernel balances new connections between them
+        if (num_listeners > 1) {
+            int enable_reuse_port = 1;
+            if (setsockopt(listener, SOL_SOCKET, SO_REUSEPORT, &enable_reuse_port, sizeof(int)) < 0) {
+                throw ManagerStateException("Server could not set socket options, error: " + std::string(strerror(errno)));
+            }
+        }
 
-    if ((status = bind(m_socketD, m_address->ai_addr, m_address->ai_addrlen)) == -1) {
-        throw ManagerStateException("Server could not bind to socket, error: " + std::string(strerror(errno)));
-    }
-    if ((status = listen(m_socketD, 10)) == -1) {
-        throw ManagerStateException("Server could not listen to socker, error:" + std::string(strerror(errno)));
+        // disable NAGLES algorithm cause we tend to send small bits of data instead of large messages
+        int enable_tcp_nodelay = 1;
+        if (setsockopt(listener, IPPROTO_TCP, TCP_NODELAY, &enable_tcp_nodelay, sizeof(int)) < 0) {
+            throw ManagerStateException("Server could not set socket options, error: " + std::string(strerror(errno)));
+        }
+
+        if ((status = bind(listener, m_address->ai_addr, m_address->ai_addrlen)) == -1) {
+            throw ManagerStateException("Server could not bind to socket, error: " + std::string(strerror(errno)));
+        }
+        if ((status = listen(listener, m_backlog)) == -1) {
+            throw ManagerStateException("Server could not listen to socker, error:" + std::string(strerror(errno)));
+        }
+        return listener;
+    };
+    m_socketD = open_listener();
+    for (std::size_t listener_index = 1; listener_index < num_listeners; listener_index++) {
+        m_reusePortSockets.push_back(open_listener());
     }
     freeaddrinfo(m_address);
+
+    // clients on the same host can skip tcp by connecting to a unix domain socket, framing is the same
+    if (!m_socketPath.empty()) {
+        struct sockaddr_un unix_address;
+        memset(&unix_address, 0, sizeof unix_address);
+        unix_address.sun_family = AF_UNIX;
+        if (m_socketPath.size() >= sizeof unix_address.sun_path) {
+            throw ManagerStateException("Server socket path is too long: " + m_socketPath);
+        }
+        strcpy(unix_address.sun_path, m_socketPath.c_str());
+        if ((m_unixSocketD = socket(AF_UNIX, SOCK_STREAM, 0)) == -1) {
+            throw ManagerStateException("Server could not get unix socket, error: " + std::string(strerror(errno)));
+        }
+
+        // a socket file left by a server that did not shut down cleanly would fail the bind
+        unlink(m_socketPath.c_str());
+        if (bind(m_unixSocketD, (struct sockaddr*) &unix_address, sizeof unix_address) == -1) {
+            throw ManagerStateException("Server could not bind to unix socket " + m_socketPath + ", error: " + std::string(strerror(errno)));
+        }
+        if (listen(m_unixSocketD, m_backlog) == -1) {
+            throw ManagerStateException("Server could not listen to unix socket, error: " + std::string(strerror(errno)));
+        }
+    }
     #else
     status = WSAStartup(MAKEWORD(2,2), &m_wsaData);
     if (status != 0) {
@@ -937,15 +2779,67 @@ void UmlServer::start() {
     }
     #endif
 
+    refresh_meta_manager_list();
     m_running = true;
-    m_acceptThread = new std::thread(acceptNewClients, this);
+    std::size_t num_workers = m_numWorkers ? m_numWorkers : std::thread::hardware_concurrency();
+    m_workers.start(num_workers ? num_workers : 1);
+    #ifndef WIN32
+    if (pipe(m_handshakeWake) == -1) {
+        m_running = false;
+        throw ManagerStateException("Server could not make handshake pipe, error: " + std::string(strerror(errno)));
+    }
+    fcntl(m_handshakeWake[0], F_SETFL, O_NONBLOCK);
+    fcntl(m_handshakeWake[1], F_SETFL, O_NONBLOCK);
+    #endif
+    #ifdef UML_SERVER_IO_URING
+    m_ioUring = new IoUringLoop;
+    if ((m_ioUring->wake_fd = eventfd(0, EFD_CLOEXEC)) == -1) {
+        delete m_ioUring;
+        m_ioUring = 0;
+        m_running = false;
+        throw ManagerStateException("Server could not make io_uring eventfd, error: " + std::string(strerror(errno)));
+    }
+    if ((status = io_uring_queue_init(UML_SERVER_IO_URING_ENTRIES, &m_ioUring->ring, 0)) < 0) {
+        delete m_ioUring;
+        m_ioUring = 0;
+        m_running = false;
+        throw ManagerStateException("Server could not set up io_uring, error: " + std::string(strerror(-status)));
+    }
+    // read buffers first, then the send buffers
+    const int num_buffers = UML_SERVER_IO_URING_BUFFERS + UML_SERVER_IO_URING_SEND_BUFFERS;
+    m_ioUring->buffers.resize(num_buffers * UML_SERVER_IO_URING_BUFFER_SIZE);
+    std::vector<struct iovec> buffer_iovecs(num_buffers);
+    for (int buffer_index = 0; buffer_index < num_buffers; buffer_index++) {
+        buffer_iovecs[buffer_index].iov_base = m_ioUring->buffers.data() + buffer_index * UML_SERVER_IO_URING_BUFFER_SIZE;
+        buffer_iovecs[buffer_index].iov_len = UML_SERVER_IO_URING_BUFFER_SIZE;
+        if (buffer_index < UML_SERVER_IO_URING_BUFFERS) {
+            m_ioUring->free_buffers.push_back(buffer_index);
+        } else {
+            m_ioUring->free_send_buffers.push_back(buffer_index);
+        }
+    }
+    if ((status = io_uring_register_buffers(&m_ioUring->ring, buffer_iovecs.data(), buffer_iovecs.size())) < 0) {
+        // reads and sends still work without registered buffers, they just get pinned every time
+        log("server could not register io_uring buffers, error: " + std::string(strerror(-status)));
+        m_ioUring->free_buffers.clear();
+        m_ioUring->free_send_buffers.clear();
+    }
+    m_handshakeThread = new std::thread(handshakeClients, this);
+    m_acceptThread = new std::thread(ioUringLoop, this);
+    #else
+    m_handshakeThread = new std::thread(handshakeClients, this);
+    m_acceptThread = new std::thread(acceptNewClients, this, m_socketD, true);
+    for (socketType listener : m_reusePortSockets) {
+        m_reusePortThreads.push_back(new std::thread(acceptNewClients, this, listener, false));
+    }
+    #endif
     m_garbageCollectionThread = new std::thread(garbageCollector, this);
     m_zombieKillerThread = new std::thread(zombieKiller, this);
     log("server set up thread to accept new clients");
 }
 
 int UmlServer::numClients() {
-    std::lock_guard<std::mutex> lck(m_acceptMtx);
+    std::lock_guard<std::mutex> clientsLck(m_clientsMtx);
     return m_clients.size();
 }
 
@@ -960,6 +2854,11 @@ void UmlServer::reset() {
 }
 
 void UmlServer::shutdownServer() {
+    if (m_shuttingDown.exchange(true)) {
+        // someone else is already shutting down, e.g. a KILL while the server is being destroyed
+        waitTillShutDown();
+        return;
+    }
     log("server shutting down");
     bool fail = false;
     struct addrinfo hints;
@@ -994,12 +2893,9 @@ void UmlServer::shutdownServer() {
     }
     
     if (!fail) {
-        // send terminate message
-        char* idMsg = new char[29];
-        std::string strBuff = m_shutdownID.string();
-        std::copy(strBuff.begin(), strBuff.end(), idMsg);
-        idMsg[28] = '\0';
-        send(tempSocket, idMsg, 29, 0);
+        // send terminate message, framed like the id of any other client so the handshake can read it
+        std::string shutdown_id = m_shutdownID.string();
+        send_message(tempSocket, shutdown_id);
         freeaddrinfo(myAddress);
         #ifndef WIN32
         close(tempSocket);
@@ -1010,17 +2906,42 @@ void UmlServer::shutdownServer() {
             WSACleanup();
         }
         #endif
-        delete[] idMsg;
 
         // wait for thread to stop
         std::unique_lock<std::mutex> rLck(m_runMtx);
         m_runCv.wait(rLck, [this]{ return !m_running; });
         m_acceptThread->join();
     }
+    // the rest of the accept threads see the server stopped the next time their poll times out
+    for (std::thread* reuse_port_thread : m_reusePortThreads) {
+        reuse_port_thread->join();
+        delete reuse_port_thread;
+    }
+    m_reusePortThreads.clear();
+    if (m_handshakeThread) {
+        wake_handshakes();
+        m_handshakeThread->join();
+        delete m_handshakeThread;
+        m_handshakeThread = 0;
+    }
 
     // close everything
     #ifndef WIN32
     close(m_socketD);
+    if (m_handshakeWake[0] != -1) {
+        close(m_handshakeWake[0]);
+        close(m_handshakeWake[1]);
+        m_handshakeWake[0] = m_handshakeWake[1] = -1;
+    }
+    for (socketType listener : m_reusePortSockets) {
+        close(listener);
+    }
+    m_reusePortSockets.clear();
+    if (m_unixSocketD != -1) {
+        close(m_unixSocketD);
+        unlink(m_socketPath.c_str());
+        m_unixSocketD = -1;
+    }
     #else
     int result = shutdown(m_socketD, SD_SEND);
     if (result == SOCKET_ERROR) {
@@ -1028,10 +2949,46 @@ void UmlServer::shutdownServer() {
         WSACleanup();
     }
     #endif
-    for (auto& client : m_clients) {
-        closeClientConnections(client.second);
+    // clients that went away are closed before the rest so no client is closed twice at once
+    m_zombieCv.notify_one();
+    m_zombieKillerThread->join();
+    delete m_zombieKillerThread;
+    m_zombieKillerThread = 0;
+
+    // stop taking requests before waiting on the ones being handled, so every strand drains after its current one
+    std::vector<std::shared_ptr<ClientInfo>> clients;
+    {
+        std::lock_guard<std::mutex> clientsLck(m_clientsMtx);
+        for (auto& client_pair : m_clients) {
+            clients.push_back(client_pair.second);
+        }
+    }
+    for (auto& client : clients) {
+        std::lock_guard<std::mutex> handlerLck(client->handlerMtx);
+        client->closed = true;
+        client->threadQueue.clear();
     }
+    for (auto& client : clients) {
+        closeClientConnections(*client);
+    }
+    m_workers.stop();
     delete m_acceptThread;
+    #ifdef UML_SERVER_IO_URING
+    if (m_ioUring) {
+        io_uring_queue_exit(&m_ioUring->ring);
+        close(m_ioUring->wake_fd);
+        delete m_ioUring;
+        m_ioUring = 0;
+    }
+    #endif
+
+    for (auto& job_pair : m_generation_jobs) {
+        if (job_pair.second.thread) {
+            job_pair.second.thread->join();
+            delete job_pair.second.thread;
+            job_pair.second.thread = 0;
+        }
+    }
 
     m_releaseQueue.clear();
     m_numEls = -1;
@@ -1039,18 +2996,42 @@ void UmlServer::shutdownServer() {
     m_garbageCollectionThread->join();
     delete m_garbageCollectionThread;
 
-    m_zombieCv.notify_one();
-    m_zombieKillerThread->join();
-    delete m_zombieKillerThread;
-
     m_shutdownV = true;
     m_shutdownCv.notify_all();
     log("server succesfully shut down");
 }
 
+void UmlServer::setSocketPath(std::string path) {
+    m_socketPath = path;
+}
+
+void UmlServer::setAcceptThreads(std::size_t num_threads) {
+    m_numAcceptThreads = num_threads > 0 ? num_threads : 1;
+}
+
+void UmlServer::setBacklog(int backlog) {
+    m_backlog = backlog;
+}
+
+void UmlServer::setHandshakeTimeout(int ms) {
+    m_handshakeTimeout = ms;
+}
+
+void UmlServer::setWorkers(std::size_t num_workers) {
+    m_numWorkers = num_workers;
+}
+
 void UmlServer::setMaxEls(int maxEls) {
     std::lock_guard<std::mutex> garbageLck(m_garbageMtx);
     m_maxEls = maxEls;
+
+    // the chunk a save of a meta manager loads comes on top of the elements already in memory, so keep it to a
+    // small part of the limit
+    set_meta_dump_chunk_size(std::clamp<std::size_t>(maxEls / UML_SERVER_META_DUMP_SHARE, 1, META_MANAGER_DUMP_CHUNK_SIZE));
+
+    // released meta elements kept serialized are not resident elements, each meta manager keeps up to the same
+    // number of them in memory on top of the limit, the rest are written to disk
+    set_meta_record_limit(maxEls);
 }
 
 int UmlServer::getMaxEls() {
@@ -1075,12 +3056,119 @@ int UmlServer::waitTillShutDown() {
     return 1;
 }
 
+std::size_t UmlServer::emit_subtree(UmlManager::Pointer<Element> root, std::size_t depth, std::string& msg) {
+    // breadth first so a subtree too big for one reply loses its deepest levels, clients get whatever
+    // was cut off on its own when they use it
+    std::size_t limit = std::min<std::size_t>(UML_SERVER_SUBTREE_LIMIT, std::max<std::size_t>(m_maxEls, 1));
+    std::deque<std::pair<ID, std::size_t>> queued_ids;
+    std::size_t num_elements = 0;
+    msg += "[" + this->emitIndividual(*root);
+    num_elements++;
+    auto queue_owned = [&](Element& el, std::size_t level) {
+        if (level >= depth) {
+            return;
+        }
+        for (auto owned : el.getOwnedElements().ptrs()) {
+            if (num_elements + queued_ids.size() == limit) {
+                return;
+            }
+            queued_ids.emplace_back(owned.id(), level + 1);
+        }
+    };
+    queue_owned(*root, 0);
+    while (!queued_ids.empty()) {
+        auto [owned_id, level] = queued_ids.front();
+        queued_ids.pop_front();
+
+        // what this loads is given back to the garbage collector like anything else a request loads
+        bool was_loaded = this->loaded(owned_id);
+        ElementPtr el = abstractGet(owned_id);
+        msg += "," + this->emitIndividual(*el);
+        num_elements++;
+        queue_owned(*el, level);
+        if (!was_loaded) {
+            queue_resident(ID::nullID(), owned_id);
+        }
+    }
+    msg += "]";
+    return num_elements;
+}
+
+void UmlServer::index_element(UmlManager::Implementation<Element>& el) {
+    std::string name;
+    if (el.is<NamedElement>()) {
+        name = el.as<NamedElement>().getName();
+    }
+    m_type_index.index(el.getID(), element_types_of(el));
+    m_name_index.index(el.getID(), name);
+
+    // only the sets that are serialized, the rest are derived from them
+    std::vector<BacklinkIndex::Reference> references;
+    this->m_types.at(el.getElementType())->forEachSet(el, [this, &references](std::string set_name, AbstractSet& set) {
+        if (set.empty() || !this->set_valid_to_emit(set)) {
+            return;
+        }
+        for (auto it = set.beginPtr(); *it != *set.endPtr(); it->next()) {
+            references.emplace_back(it->getCurr().id(), set_name);
+        }
+    });
+    m_backlinks.set_references(el.getID(), references);
+
+    // meta elements emit the properties of their profile by the names they had when first used, and
+    // changes under a generation root are what extending its manager walks
+    for (auto& meta_manager_pair : meta_managers()) {
+        if (el.is<Property>()) {
+            meta_manager_pair.second.rename_property(el.getID(), name);
+        }
+        meta_manager_pair.second.element_changed(el.getID(), el.getOwner().id());
+    }
+
+    if (el.getID() == m_qualified_names.get_root()) {
+        m_qualified_names.set_root(el.getID(), name);
+    } else {
+        m_qualified_names.index(el.getID(), name, el.getOwner().id());
+    }
+
+    // elements added to one of el's sets moved without being put themselves, what they own follows them
+    for (auto& owned_id : el.getOwnedElements().ids()) {
+        if (!loaded(owned_id)) {
+            continue;
+        }
+        auto indexed_owner = m_qualified_names.owner_of(owned_id);
+        if (indexed_owner && *indexed_owner != el.getID()) {
+            UmlManager::Pointer<Element> owned = get(owned_id);
+            index_element(*owned);
+        }
+    }
+}
+
 void UmlServer::setRoot(AbstractElementPtr el) {
     BaseManager::setRoot(el);
+    m_qualified_names.clear();
+    m_type_index.clear();
+    m_backlinks.clear();
+    m_name_index.clear();
     if (!el) {
         return;
     }
-    m_urls[""] = el->getID();
+
+    // index what is in memory under the new root, the rest is indexed as it is put or posted
+    UmlManager::Pointer<Element> root = el;
+    m_qualified_names.set_root(root.id(), root->is<NamedElement>() ? root->as<NamedElement>().getName() : "");
+    index_element(*root);
+    std::vector<UmlManager::Pointer<Element>> stack = { root };
+    while (!stack.empty()) {
+        auto curr = stack.back();
+        stack.pop_back();
+        for (auto& owned_id : curr->getOwnedElements().ids()) {
+            if (!loaded(owned_id)) {
+                continue;
+            }
+            UmlManager::Pointer<Element> owned = get(owned_id);
+            index_element(*owned);
+            stack.push_back(owned);
+        }
+    }
 }
 
 void UmlServer::setRoot(UmlServer::Implementation<Element>& el) {
@@ -0,0 +1,101 @@
+#include "uml-server/workerPool.h"
+#include <stdexcept>
+
+namespace UML {
+
+// worker the current thread is, so tasks it submits stay on its own queue
+static thread_local WorkerPool* current_pool = 0;
+static thread_local std::size_t current_worker = 0;
+
+WorkerPool::~WorkerPool() {
+    stop();
+}
+
+void WorkerPool::start(std::size_t num_workers) {
+    {
+        std::lock_guard<std::mutex> idleLck(m_idleMtx);
+        m_stopping = false;
+    }
+    for (std::size_t worker_index = 0; worker_index < num_workers; worker_index++) {
+        m_workers.push_back(std::make_unique<Worker>());
+    }
+    for (std::size_t worker_index = 0; worker_index < num_workers; worker_index++) {
+        m_workers[worker_index]->thread = std::thread(&WorkerPool::run, this, worker_index);
+    }
+}
+
+void WorkerPool::stop() {
+    if (current_pool == this) {
+        throw std::logic_error("worker pool can not be stopped from one of its own workers!");
+    }
+    {
+        std::lock_guard<std::mutex> idleLck(m_idleMtx);
+        m_stopping = true;
+    }
+    m_idleCv.notify_all();
+    for (auto& worker : m_workers) {
+        if (worker->thread.joinable()) {
+            worker->thread.join();
+        }
+    }
+}
+
+void WorkerPool::submit(std::function<void()> task) {
+    std::size_t worker_index = 0;
+    {
+        std::lock_guard<std::mutex> idleLck(m_idleMtx);
+        // tasks still running while stopping can queue more, they are run before the workers stop
+        if ((m_stopping && current_pool != this) || m_workers.empty()) {
+            return;
+        }
+        m_num_tasks++;
+        worker_index = current_pool == this ? current_worker : m_next_worker++ % m_workers.size();
+    }
+    {
+        Worker& worker = *m_workers[worker_index];
+        std::lock_guard<std::mutex> workerLck(worker.mtx);
+        worker.tasks.push_back(std::move(task));
+    }
+    m_idleCv.notify_one();
+}
+
+bool WorkerPool::take(std::size_t worker_index, std::function<void()>& task) {
+    for (std::size_t offset = 0; offset < m_workers.size(); offset++) {
+        Worker& worker = *m_workers[(worker_index + offset) % m_workers.size()];
+        std::lock_guard<std::mutex> workerLck(worker.mtx);
+        if (worker.tasks.empty()) {
+            continue;
+        }
+        if (offset == 0) {
+            task = std::move(worker.tasks.front());
+            worker.tasks.pop_front();
+        } else {
+            task = std::move(worker.tasks.back());
+            worker.tasks.pop_back();
+        }
+        return true;
+    }
+    return false;
+}
+
+void WorkerPool::run(std::size_t worker_index) {
+    current_pool = this;
+    current_worker = worker_index;
+    while (true) {
+        std::function<void()> task;
+        if (take(worker_index, task)) {
+            {
+                std::lock_guard<std::mutex> idleLck(m_idleMtx);
+                m_num_tasks--;
+            }
+            task();
+            continue;
+        }
+        std::unique_lock<std::mutex> idleLck(m_idleMtx);
+        m_idleCv.wait(idleLck, [this] { return m_num_tasks > 0 || m_stopping; });
+        if (m_num_tasks == 0 && m_stopping) {
+            return;
+        }
+    }
+}
+}